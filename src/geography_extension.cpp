@@ -11,7 +11,11 @@
 #include "s2_cell_ops.hpp"
 #include "s2_data.hpp"
 #include "s2_dependencies.hpp"
+#include "s2_geography_cache.hpp"
 #include "s2_geography_ops.hpp"
+#include "s2_index.hpp"
+#include "s2_settings.hpp"
+#include "s2_spatial_join.hpp"
 #include "s2_types.hpp"
 
 namespace duckdb {
@@ -27,10 +31,14 @@ static void LoadInternal(DatabaseInstance& instance) {
   ExtensionUtil::RegisterFunction(instance, s2_scalar_function);
 
   duckdb_s2::RegisterTypes(instance);
+  duckdb_s2::RegisterSettings(instance);
   duckdb_s2::RegisterS2Dependencies(instance);
   duckdb_s2::RegisterS2CellOps(instance);
   duckdb_s2::RegisterS2GeographyOps(instance);
   duckdb_s2::RegisterS2Data(instance);
+  duckdb_s2::RegisterS2SpatialJoin(instance);
+  duckdb_s2::RegisterS2Index(instance);
+  duckdb_s2::RegisterGeographyCache(instance);
 }
 
 void GeographyExtension::Load(DuckDB& db) { LoadInternal(*db.instance); }
@@ -1,12 +1,92 @@
 #pragma once
 
+#include <type_traits>
+
 #include "duckdb.hpp"
 
+#include "duckdb/execution/expression_executor_state.hpp"
+#include "duckdb/function/cast/default_casts.hpp"
 #include "duckdb/function/function_set.hpp"
 #include "duckdb/function/scalar_function.hpp"
 
 namespace duckdb {
 
+//------------------------------------------------------------------------------
+// Scalar Function Local State
+//------------------------------------------------------------------------------
+
+// Function-local state that wraps a T, which is constructed (from the ClientContext
+// if T has such a constructor) once for each thread that executes the function and
+// reused for every chunk (including any buffers it owns).
+template <class T>
+class ScalarFunctionLocalState : public FunctionLocalState {
+ public:
+  explicit ScalarFunctionLocalState(ClientContext& context) : value(Make(context)) {}
+
+  T value;
+
+  static unique_ptr<FunctionLocalState> Init(ExpressionState& state,
+                                             const BoundFunctionExpression& expr,
+                                             FunctionData* bind_data) {
+    return make_uniq<ScalarFunctionLocalState<T>>(state.GetContext());
+  }
+
+  static T& Get(ExpressionState& state) {
+    auto local_state = ExecuteFunctionState::GetFunctionState(state);
+    if (!local_state) {
+      throw InternalException("Function local state was not initialized");
+    }
+
+    return local_state->Cast<ScalarFunctionLocalState<T>>().value;
+  }
+
+ private:
+  static T Make(ClientContext& context) {
+    if constexpr (std::is_constructible<T, ClientContext&>::value) {
+      return T(context);
+    } else {
+      return T();
+    }
+  }
+};
+
+//------------------------------------------------------------------------------
+// Cast Function Local State
+//------------------------------------------------------------------------------
+
+// Cast-local state that wraps a T, like ScalarFunctionLocalState. Casts may be
+// evaluated without a ClientContext (e.g., some constant folding), so T is
+// constructed from an optional_ptr<ClientContext> if it has such a constructor.
+template <class T>
+class CastFunctionLocalState : public FunctionLocalState {
+ public:
+  explicit CastFunctionLocalState(optional_ptr<ClientContext> context)
+      : value(Make(context)) {}
+
+  T value;
+
+  static unique_ptr<FunctionLocalState> Init(CastLocalStateParameters& parameters) {
+    return make_uniq<CastFunctionLocalState<T>>(parameters.context);
+  }
+
+  static T& Get(CastParameters& parameters) {
+    if (!parameters.local_state) {
+      throw InternalException("Cast local state was not initialized");
+    }
+
+    return parameters.local_state->Cast<CastFunctionLocalState<T>>().value;
+  }
+
+ private:
+  static T Make(optional_ptr<ClientContext> context) {
+    if constexpr (std::is_constructible<T, optional_ptr<ClientContext>>::value) {
+      return T(context);
+    } else {
+      return T();
+    }
+  }
+};
+
 //------------------------------------------------------------------------------
 // Scalar Function Variant Builder
 //------------------------------------------------------------------------------
@@ -18,6 +98,14 @@ class ScalarFunctionVariantBuilder {
   void AddParameter(const char* name, LogicalType type);
   void SetReturnType(LogicalType type);
   void SetFunction(scalar_function_t fn);
+  void SetBind(bind_scalar_function_t bind);
+  void SetInitLocalState(init_local_state_t init);
+
+  // Use a ScalarFunctionLocalState<T> as the local state of this variant
+  template <class T>
+  void SetLocalState() {
+    SetInitLocalState(ScalarFunctionLocalState<T>::Init);
+  }
 
  private:
   explicit ScalarFunctionVariantBuilder()
@@ -42,6 +130,14 @@ inline void ScalarFunctionVariantBuilder::SetFunction(scalar_function_t fn) {
   function.function = fn;
 }
 
+inline void ScalarFunctionVariantBuilder::SetBind(bind_scalar_function_t bind) {
+  function.bind = bind;
+}
+
+inline void ScalarFunctionVariantBuilder::SetInitLocalState(init_local_state_t init) {
+  function.init_local_state = init;
+}
+
 //------------------------------------------------------------------------------
 // Scalar Function Builder
 //------------------------------------------------------------------------------
@@ -6,6 +6,17 @@ namespace duckdb {
 
 namespace duckdb_s2 {
 
+// Convert longitude/latitude pairs (in degrees) to leaf cell ids (i.e., the
+// same values as s2_cellfromlonlat()). Pairs where both values are NaN are
+// converted to the sentinel (invalid) cell id. Uses AVX2 or AVX-512 when the
+// CPU supports it; the result is identical to the scalar version either way.
+void LngLatToCellIds(const double* lng, const double* lat, idx_t count, uint64_t* out);
+
+// If wkb is a POINT, set lnglat to its (first two) coordinates (NaN for an empty
+// point) and return true. Returns false for anything else, including invalid WKB
+// (which is left to the WKBReader to report).
+bool TryLngLatFromPointWKB(string_t wkb, double* lnglat);
+
 void RegisterS2CellOps(DatabaseInstance& instance);
 
 }
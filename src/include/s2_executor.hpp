@@ -0,0 +1,129 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "duckdb.hpp"
+#include "duckdb/common/vector_operations/generic_executor.hpp"
+#include "duckdb/common/vector_operations/unary_executor.hpp"
+
+namespace duckdb {
+
+namespace duckdb_s2 {
+
+// Execution helpers for functions of geographies that are expensive to compute
+// (e.g., because they require a full decode)
+struct GeographyExecutor {
+  // Like UnaryExecutor::Execute(), except that for a dictionary vector fun is
+  // called once for each distinct dictionary entry and its result is copied to
+  // every row that refers to that entry. Dictionary vectors are common for
+  // geographies (e.g., the build side of a join or Parquet dictionary pages) and
+  // often repeat the same (large) value many times. Constant input results in
+  // constant output.
+  template <class INPUT_TYPE, class RESULT_TYPE, class FUNC>
+  static void ExecuteUnary(Vector& source, Vector& result, idx_t count, FUNC&& fun) {
+    UnifiedVectorFormat format;
+    idx_t dictionary_size = DictionaryLookupSize(source, count, format);
+    if (dictionary_size == 0) {
+      UnaryExecutor::Execute<INPUT_TYPE, RESULT_TYPE>(source, result, count, fun);
+      return;
+    }
+
+    auto input = UnifiedVectorFormat::GetData<INPUT_TYPE>(format);
+
+    result.SetVectorType(VectorType::FLAT_VECTOR);
+    auto result_data = FlatVector::GetData<RESULT_TYPE>(result);
+    auto& result_validity = FlatVector::Validity(result);
+    result_validity.SetAllValid(count);
+
+    // The first row of the output that refers to each dictionary entry. Results
+    // that live in the result's string heap (or list child) can be shared among
+    // rows.
+    idx_t first_row[kMaxDictionaryLookupSize];
+    std::fill_n(first_row, dictionary_size, DConstants::INVALID_INDEX);
+
+    for (idx_t i = 0; i < count; i++) {
+      idx_t idx = format.sel->get_index(i);
+      if (!format.validity.RowIsValid(idx)) {
+        result_validity.SetInvalid(i);
+        continue;
+      }
+
+      if (first_row[idx] == DConstants::INVALID_INDEX) {
+        first_row[idx] = i;
+        result_data[i] = fun(input[idx]);
+      } else {
+        result_data[i] = result_data[first_row[idx]];
+      }
+    }
+  }
+
+  // Like ExecuteUnary() with the input and result types of GenericExecutor (e.g.,
+  // StructTypeQuaternary for a STRUCT result), whose values are kept for each
+  // distinct dictionary entry and assigned to every row that refers to it
+  template <class INPUT_TYPE, class RESULT_TYPE, class FUNC>
+  static void ExecuteUnaryGeneric(Vector& source, Vector& result, idx_t count,
+                                  FUNC&& fun) {
+    UnifiedVectorFormat format;
+    idx_t dictionary_size = DictionaryLookupSize(source, count, format);
+    if (dictionary_size == 0) {
+      GenericExecutor::ExecuteUnary<INPUT_TYPE, RESULT_TYPE>(source, result, count, fun);
+      return;
+    }
+
+    auto input = UnifiedVectorFormat::GetData<decltype(INPUT_TYPE::val)>(format);
+
+    result.SetVectorType(VectorType::FLAT_VECTOR);
+
+    // The position in results of the value for each dictionary entry
+    idx_t result_idx[kMaxDictionaryLookupSize];
+    std::fill_n(result_idx, dictionary_size, DConstants::INVALID_INDEX);
+    std::vector<RESULT_TYPE> results;
+
+    for (idx_t i = 0; i < count; i++) {
+      idx_t idx = format.sel->get_index(i);
+      if (!format.validity.RowIsValid(idx)) {
+        FlatVector::SetNull(result, i, true);
+        continue;
+      }
+
+      if (result_idx[idx] == DConstants::INVALID_INDEX) {
+        INPUT_TYPE value(input[idx]);
+        result_idx[idx] = results.size();
+        results.push_back(fun(value));
+      }
+
+      RESULT_TYPE::AssignResult(result, i, results[result_idx[idx]]);
+    }
+  }
+
+ private:
+  // Dictionary entries are looked up in a table on the stack with one slot per
+  // entry, so vectors that refer to entries beyond this are executed as if they
+  // were flat (e.g., a dictionary over a large build side of a join)
+  static constexpr idx_t kMaxDictionaryLookupSize = STANDARD_VECTOR_SIZE;
+
+  // Returns the number of slots needed to look up the dictionary entries that the
+  // rows of source refer to (i.e., the largest index + 1) and populates format,
+  // or returns 0 if source isn't a dictionary that can be deduplicated this way
+  static idx_t DictionaryLookupSize(Vector& source, idx_t count,
+                                    UnifiedVectorFormat& format) {
+    if (source.GetVectorType() != VectorType::DICTIONARY_VECTOR) {
+      return 0;
+    }
+
+    source.ToUnifiedFormat(count, format);
+    idx_t size = 0;
+    for (idx_t i = 0; i < count; i++) {
+      size = MaxValue<idx_t>(size, format.sel->get_index(i) + 1);
+      if (size > kMaxDictionaryLookupSize) {
+        return 0;
+      }
+    }
+
+    return size;
+  }
+};
+
+}  // namespace duckdb_s2
+}  // namespace duckdb
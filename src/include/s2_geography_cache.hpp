@@ -0,0 +1,106 @@
+#pragma once
+
+#include <atomic>
+#include <list>
+
+#include "duckdb.hpp"
+#include "duckdb/common/types/hash.hpp"
+
+#include "s2_prepared_geography.hpp"
+
+namespace duckdb {
+
+namespace duckdb_s2 {
+
+// Counters shared by all GeographyCache instances (see s2_cache_stats())
+struct GeographyCacheStats {
+  static std::atomic<int64_t> hits;
+  static std::atomic<int64_t> misses;
+  static std::atomic<int64_t> evictions;
+};
+
+// A bounded least-recently-used cache of decoded and indexed geographies keyed
+// by the content of their encoded bytes. This is intended for use by a single
+// thread (e.g., in the local state of a scalar function) for an argument where
+// the same value is likely to occur many times (e.g., the polygon side of a
+// join between points and polygons).
+class GeographyCache {
+ public:
+  explicit GeographyCache(idx_t memory_limit) : memory_limit_(memory_limit) {}
+
+  // Returns a prepared version of data. The reference is valid until the next
+  // call to Prepare().
+  const PreparedGeography& Prepare(string_t data) {
+    if (memory_limit_ == 0) {
+      return uncached_.Init(data).Prepare();
+    }
+
+    hash_t hash = Hash(data.GetData(), data.GetSize());
+    auto range = entries_.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+      if (it->second->geog->Data() == data) {
+        lru_.splice(lru_.begin(), lru_, it->second);
+        GeographyCacheStats::hits++;
+        return *lru_.front().geog;
+      }
+    }
+
+    GeographyCacheStats::misses++;
+    auto geog = make_uniq<PreparedGeography>();
+    geog->InitOwned(data.GetString()).Prepare();
+    idx_t size = geog->MemoryUsage();
+
+    // Too big to ever fit in the cache
+    if (size > memory_limit_) {
+      too_large_ = std::move(geog);
+      return *too_large_;
+    }
+
+    lru_.push_front(Entry{hash, std::move(geog), size});
+    entries_.insert({hash, lru_.begin()});
+    memory_used_ += size;
+
+    // Evict until we fit (this never evicts the entry we just added)
+    while (memory_used_ > memory_limit_) {
+      Evict();
+    }
+
+    return *lru_.front().geog;
+  }
+
+  idx_t MemoryUsage() const { return memory_used_; }
+
+ private:
+  struct Entry {
+    hash_t hash;
+    unique_ptr<PreparedGeography> geog;
+    idx_t size;
+  };
+
+  idx_t memory_limit_;
+  idx_t memory_used_{0};
+  std::list<Entry> lru_;
+  std::unordered_multimap<hash_t, std::list<Entry>::iterator> entries_;
+  PreparedGeography uncached_;
+  unique_ptr<PreparedGeography> too_large_;
+
+  void Evict() {
+    auto last = std::prev(lru_.end());
+    auto range = entries_.equal_range(last->hash);
+    for (auto it = range.first; it != range.second; ++it) {
+      if (it->second == last) {
+        entries_.erase(it);
+        break;
+      }
+    }
+
+    memory_used_ -= last->size;
+    lru_.erase(last);
+    GeographyCacheStats::evictions++;
+  }
+};
+
+void RegisterGeographyCache(DatabaseInstance& instance);
+
+}  // namespace duckdb_s2
+}  // namespace duckdb
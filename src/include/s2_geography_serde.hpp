@@ -1,38 +1,260 @@
+#pragma once
+
+#include <cmath>
 
 #include "duckdb.hpp"
 
+#include "s2/s2latlng_rect.h"
+#include "s2/s2projections.h"
+#include "s2/s2region_coverer.h"
 #include "s2geography/geography.h"
 
 namespace duckdb {
 
 namespace duckdb_s2 {
 
+// Flags used by this extension in addition to those defined by s2geography.
+// These are never passed on to s2geography, which doesn't know about them.
+struct EncodeFlags {
+  // An encoded S2LatLngRect follows the covering
+  static constexpr uint8_t kFlagBounds = 0x80;
+
+  // An interior covering (a uint8 cell count followed by that many cell ids)
+  // follows the covering and bounds
+  static constexpr uint8_t kFlagInteriorCovering = 0x40;
+
+  static constexpr uint8_t kFlagsExtension = kFlagBounds | kFlagInteriorCovering;
+};
+
 class GeographyDecoder {
  public:
   s2geography::EncodeTag tag{};
   std::vector<S2CellId> covering{};
 
+  // Only valid if HasBounds() after a call to DecodeTagAndCovering() or
+  // DecodeTagAndBounds()
+  S2LatLngRect bounds{S2LatLngRect::Empty()};
+
+  // Only valid after a call to DecodeInteriorCovering(): cells that are
+  // completely inside the geography (empty if none were stored)
+  std::vector<S2CellId> interior_covering{};
+
   GeographyDecoder() = default;
 
   void DecodeTag(string_t data) {
     decoder_.reset(data.GetPrefix(), 4);
-    tag.Decode(&decoder_);
+    ReadTag();
   }
 
   void DecodeTagAndCovering(string_t data) {
     decoder_.reset(data.GetData(), data.GetSize());
     covering.clear();
-    tag.Decode(&decoder_);
+    ReadTag();
     tag.DecodeCovering(&decoder_, &covering);
+    ReadBounds();
+  }
+
+  // Decode the tag and, if present, the bounds without decoding the covering.
+  // Returns true if bounds were present.
+  bool DecodeTagAndBounds(string_t data) {
+    decoder_.reset(data.GetData(), data.GetSize());
+    ReadTag();
+    if (!HasBounds()) {
+      return false;
+    }
+
+    tag.SkipCovering(&decoder_);
+    ReadBounds();
+    return true;
+  }
+
+  bool HasBounds() const { return tag.flags & EncodeFlags::kFlagBounds; }
+
+  // Decode the tag and interior covering without decoding the covering. This is
+  // separate from DecodeTagAndCovering() because the interior covering is only
+  // useful once the coverings of two geographies are known to intersect.
+  // Returns true if an interior covering was present.
+  bool DecodeInteriorCovering(string_t data) {
+    decoder_.reset(data.GetData(), data.GetSize());
+    interior_covering.clear();
+    ReadTag();
+    if (!HasInteriorCovering()) {
+      return false;
+    }
+
+    tag.SkipCovering(&decoder_);
+    ReadBounds();
+    ReadInteriorCovering(&interior_covering);
+    return true;
+  }
+
+  bool HasInteriorCovering() const {
+    return tag.flags & EncodeFlags::kFlagInteriorCovering;
   }
 
   std::unique_ptr<s2geography::Geography> Decode(string_t data) {
     decoder_.reset(data.GetData(), data.GetSize());
-    return s2geography::Geography::DecodeTagged(&decoder_);
+    ReadTag();
+    if (!(tag.flags & EncodeFlags::kFlagsExtension)) {
+      decoder_.reset(data.GetData(), data.GetSize());
+      return s2geography::Geography::DecodeTagged(&decoder_);
+    }
+
+    return DecodeWithTag(SkipToGeography());
+  }
+
+  // Decode data into a geography owned by this decoder. The geography object is
+  // reused from row to row instead of being allocated for every value; anything
+  // s2geography allocates while decoding into it (e.g., the S2Polyline or
+  // S2Polygon of each value) is not, so decoding is not allocation-free. The
+  // result is valid until the next call to DecodeInPlace() and must not be
+  // retained beyond that.
+  const s2geography::Geography& DecodeInPlace(string_t data) {
+    decoder_.reset(data.GetData(), data.GetSize());
+    ReadTag();
+
+    s2geography::EncodeTag geog_tag = SkipToGeography();
+    switch (geog_tag.kind) {
+      case s2geography::GeographyKind::CELL_CENTER:
+      case s2geography::GeographyKind::POINT:
+        return DecodeInto(point_, geog_tag);
+      case s2geography::GeographyKind::POLYLINE:
+        return DecodeInto(polyline_, geog_tag);
+      case s2geography::GeographyKind::POLYGON:
+        return DecodeInto(polygon_, geog_tag);
+      case s2geography::GeographyKind::GEOGRAPHY_COLLECTION:
+        return DecodeInto(collection_, geog_tag);
+      case s2geography::GeographyKind::SHAPE_INDEX:
+      case s2geography::GeographyKind::ENCODED_SHAPE_INDEX:
+        return DecodeInto(shape_index_, geog_tag);
+      default:
+        throw InvalidInputException("Can't decode GEOGRAPHY with kind " +
+                                    std::to_string(static_cast<int>(geog_tag.kind)));
+    }
   }
 
  private:
   Decoder decoder_{};
+
+  // s2geography's EncodeTag::Decode() rejects flags it doesn't know about
+  void ReadTag() {
+    if (decoder_.avail() < 4) {
+      throw InvalidInputException("Can't decode GEOGRAPHY with fewer than 4 bytes");
+    }
+
+    tag.kind = static_cast<s2geography::GeographyKind>(decoder_.get8());
+    tag.flags = decoder_.get8();
+    tag.covering_size = decoder_.get8();
+    tag.reserved = decoder_.get8();
+  }
+
+  // Reused by DecodeInPlace()
+  std::unique_ptr<s2geography::PointGeography> point_;
+  std::unique_ptr<s2geography::PolylineGeography> polyline_;
+  std::unique_ptr<s2geography::PolygonGeography> polygon_;
+  std::unique_ptr<s2geography::GeographyCollection> collection_;
+  std::unique_ptr<s2geography::EncodedShapeIndexGeography> shape_index_;
+
+  // Skip everything s2geography doesn't know about (after the tag has been
+  // read) and return the tag that the rest should be decoded with. The covering
+  // of a cell center is the point itself and is left in place (cell centers
+  // never have extension fields); anything else is decoded as if it had been
+  // written without a covering.
+  s2geography::EncodeTag SkipToGeography() {
+    s2geography::EncodeTag geog_tag = tag;
+    geog_tag.flags &= ~EncodeFlags::kFlagsExtension;
+    if (tag.kind == s2geography::GeographyKind::CELL_CENTER) {
+      return geog_tag;
+    }
+
+    tag.SkipCovering(&decoder_);
+    ReadBounds();
+    ReadInteriorCovering(nullptr);
+    geog_tag.covering_size = 0;
+    return geog_tag;
+  }
+
+  template <typename T>
+  const T& DecodeInto(std::unique_ptr<T>& geog, const s2geography::EncodeTag& geog_tag) {
+    if (!geog) {
+      geog = std::make_unique<T>();
+    }
+
+    geog->Decode(&decoder_, geog_tag);
+    return *geog;
+  }
+
+  void ReadBounds() {
+    if (!HasBounds()) {
+      return;
+    }
+
+    if (!bounds.Decode(&decoder_)) {
+      throw InvalidInputException("Can't decode GEOGRAPHY bounds");
+    }
+  }
+
+  // Read the interior covering into cells or skip it if cells is nullptr
+  void ReadInteriorCovering(std::vector<S2CellId>* cells) {
+    if (!HasInteriorCovering()) {
+      return;
+    }
+
+    if (decoder_.avail() < 1) {
+      throw InvalidInputException("Can't decode GEOGRAPHY interior covering");
+    }
+
+    size_t num_cells = decoder_.get8();
+    if (decoder_.avail() < num_cells * sizeof(uint64_t)) {
+      throw InvalidInputException("Can't decode GEOGRAPHY interior covering");
+    }
+
+    if (cells == nullptr) {
+      decoder_.skip(num_cells * sizeof(uint64_t));
+      return;
+    }
+
+    cells->reserve(num_cells);
+    for (size_t i = 0; i < num_cells; i++) {
+      cells->push_back(S2CellId(decoder_.get64()));
+    }
+  }
+
+  std::unique_ptr<s2geography::Geography> DecodeWithTag(
+      const s2geography::EncodeTag& geog_tag) {
+    switch (geog_tag.kind) {
+      case s2geography::GeographyKind::CELL_CENTER:
+      case s2geography::GeographyKind::POINT: {
+        auto geog = make_uniq<s2geography::PointGeography>();
+        geog->Decode(&decoder_, geog_tag);
+        return std::move(geog);
+      }
+      case s2geography::GeographyKind::POLYLINE: {
+        auto geog = make_uniq<s2geography::PolylineGeography>();
+        geog->Decode(&decoder_, geog_tag);
+        return std::move(geog);
+      }
+      case s2geography::GeographyKind::POLYGON: {
+        auto geog = make_uniq<s2geography::PolygonGeography>();
+        geog->Decode(&decoder_, geog_tag);
+        return std::move(geog);
+      }
+      case s2geography::GeographyKind::GEOGRAPHY_COLLECTION: {
+        auto geog = make_uniq<s2geography::GeographyCollection>();
+        geog->Decode(&decoder_, geog_tag);
+        return std::move(geog);
+      }
+      case s2geography::GeographyKind::SHAPE_INDEX:
+      case s2geography::GeographyKind::ENCODED_SHAPE_INDEX: {
+        auto geog = make_uniq<s2geography::EncodedShapeIndexGeography>();
+        geog->Decode(&decoder_, geog_tag);
+        return std::move(geog);
+      }
+      default:
+        throw InvalidInputException("Can't decode GEOGRAPHY with kind " +
+                                    std::to_string(static_cast<int>(geog_tag.kind)));
+    }
+  }
 };
 
 class GeographyEncoder {
@@ -41,17 +263,266 @@ class GeographyEncoder {
     options_.set_coding_hint(s2coding::CodingHint::COMPACT);
     options_.set_enable_lazy_decode(true);
     options_.set_include_covering(true);
+    interior_coverer_.mutable_options()->set_max_cells(kInteriorCoveringMaxCells);
   }
 
-  string_t Encode(const s2geography::Geography& geog) {
-    encoder_.Resize(0);
-    geog.EncodeTagged(&encoder_, options_);
-    return string_t{encoder_.base(), static_cast<uint32_t>(encoder_.length())};
+  void set_coding_hint(s2coding::CodingHint hint) { options_.set_coding_hint(hint); }
+
+  // Compute the covering stored with each value using an S2RegionCoverer with
+  // these options instead of s2geography's cell union bound (which is quicker
+  // to compute but can't be tuned)
+  void set_covering_options(const S2RegionCoverer::Options& options) {
+    *coverer_.mutable_options() = options;
+    use_coverer_ = true;
+    options_.set_include_covering(false);
+  }
+
+  // Go back to storing s2geography's cell union bound as the covering
+  void clear_covering_options() {
+    use_coverer_ = false;
+    options_.set_include_covering(true);
+  }
+
+  // Store the S2LatLngRect bound after the covering of non-point geographies
+  // such that it can be read without decoding the whole geography. Values
+  // written with this can't be read by s2geography (which rejects unknown
+  // flags), so it is off unless requested (s2_encode_extensions).
+  void set_include_bounds(bool include_bounds) { include_bounds_ = include_bounds; }
+
+  // Store an interior covering (i.e., cells that are completely inside the
+  // geography) after the bounds of polygons such that predicates can prove
+  // containment without an exact test. This runs an S2RegionCoverer (which
+  // builds the polygon's index) for every polygon, so it is off unless requested
+  // (s2_encode_interior_covering).
+  void set_include_interior_covering(bool include_interior_covering) {
+    include_interior_covering_ = include_interior_covering;
+  }
+
+  // Encode geog into the string heap of result. s2geography serializes into a
+  // buffer owned by this encoder (it can't report the encoded size up front,
+  // which writing into the heap directly would need), which is then copied into
+  // the heap once with the bounds and interior covering spliced in on the way.
+  string_t Encode(const s2geography::Geography& geog, Vector& result) {
+    EncodeParts(geog);
+    string_t out = StringVector::EmptyString(result, EncodedSize());
+    WriteParts(out.GetDataWriteable());
+    out.Finalize();
+    return out;
   }
 
  private:
+  // The number of cells in the interior covering of a polygon
+  static constexpr int kInteriorCoveringMaxCells = 8;
+
+  // The covering size is stored in a single byte of the tag
+  static constexpr size_t kMaxCoveringSize = 255;
+
   Encoder encoder_{};
+  Encoder extension_{};
+  uint8_t extension_flags_{0};
+  size_t header_size_{0};
   s2geography::EncodeOptions options_{};
+  bool include_bounds_{false};
+  bool include_interior_covering_{false};
+  S2RegionCoverer interior_coverer_{};
+  std::vector<S2CellId> interior_covering_{};
+  bool use_coverer_{false};
+  S2RegionCoverer coverer_{};
+  std::vector<S2CellId> covering_{};
+  bool replace_covering_{false};
+
+  // Serialize geog with s2geography and, if needed, its covering (when computed
+  // by coverer_), bounds, and interior covering. These go in between the tag and
+  // the rest of the geography, which happens when the parts are written out.
+  void EncodeParts(const s2geography::Geography& geog) {
+    encoder_.Resize(0);
+    extension_.Resize(0);
+    extension_flags_ = 0;
+    replace_covering_ = false;
+    header_size_ = 0;
+    geog.EncodeTagged(&encoder_, options_);
+    if (encoder_.length() < 4) {
+      return;
+    }
+
+    auto header = reinterpret_cast<const uint8_t*>(encoder_.base());
+    auto kind = static_cast<s2geography::GeographyKind>(header[0]);
+    if (header[1] & s2geography::EncodeTag::kFlagEmpty) {
+      return;
+    }
+
+    header_size_ = 4 + header[2] * sizeof(uint64_t);
+    std::unique_ptr<S2Region> region;
+
+    // The covering of a cell center is its cell (which s2geography always writes
+    // and which keeps the value small enough to be stored inline)
+    if (use_coverer_ && kind != s2geography::GeographyKind::CELL_CENTER) {
+      region = geog.Region();
+      EncodeCovering(geog, *region);
+    }
+
+    if ((!include_bounds_ && !include_interior_covering_) ||
+        kind == s2geography::GeographyKind::POINT ||
+        kind == s2geography::GeographyKind::CELL_CENTER) {
+      return;
+    }
+
+    if (!region) {
+      region = geog.Region();
+    }
+
+    if (include_bounds_) {
+      region->GetRectBound().Encode(&extension_);
+      extension_flags_ |= EncodeFlags::kFlagBounds;
+    }
+
+    if (include_interior_covering_ && kind == s2geography::GeographyKind::POLYGON) {
+      EncodeInteriorCovering(*region);
+    }
+  }
+
+  // The covering computed here replaces the one written by s2geography (which
+  // was asked not to write one but may still have done so), falling back to
+  // s2geography's bound if the options allow more cells than fit in the tag
+  void EncodeCovering(const s2geography::Geography& geog, const S2Region& region) {
+    coverer_.GetCovering(region, &covering_);
+    if (covering_.size() > kMaxCoveringSize) {
+      covering_.clear();
+      geog.GetCellUnionBound(&covering_);
+      if (covering_.size() > kMaxCoveringSize) {
+        covering_.clear();
+      }
+    }
+
+    extension_.Ensure(covering_.size() * sizeof(uint64_t));
+    for (const S2CellId& cell : covering_) {
+      extension_.put64(cell.id());
+    }
+
+    replace_covering_ = true;
+  }
+
+  void EncodeInteriorCovering(const S2Region& region) {
+    interior_coverer_.GetInteriorCovering(region, &interior_covering_);
+    if (interior_covering_.empty()) {
+      return;
+    }
+
+    extension_.Ensure(1 + interior_covering_.size() * sizeof(uint64_t));
+    extension_.put8(static_cast<uint8_t>(interior_covering_.size()));
+    for (const S2CellId& cell : interior_covering_) {
+      extension_.put64(cell.id());
+    }
+
+    extension_flags_ |= EncodeFlags::kFlagInteriorCovering;
+  }
+
+  // The part of encoder_ written before extension_: the tag and, unless it is
+  // replaced, the covering written by s2geography
+  size_t PrefixSize() const { return replace_covering_ ? 4 : header_size_; }
+
+  size_t EncodedSize() const {
+    return PrefixSize() + extension_.length() + encoder_.length() - header_size_;
+  }
+
+  void WriteParts(char* out) const {
+    if (extension_.length() == 0 && !replace_covering_) {
+      memcpy(out, encoder_.base(), encoder_.length());
+      return;
+    }
+
+    size_t prefix_size = PrefixSize();
+    memcpy(out, encoder_.base(), prefix_size);
+    if (extension_.length() > 0) {
+      memcpy(out + prefix_size, extension_.base(), extension_.length());
+    }
+    memcpy(out + prefix_size + extension_.length(), encoder_.base() + header_size_,
+           encoder_.length() - header_size_);
+    out[1] = static_cast<char>(out[1] | extension_flags_);
+    if (replace_covering_) {
+      out[2] = static_cast<char>(covering_.size());
+    }
+  }
+};
+
+// Encodes a point as the center of a leaf cell: the tag followed by the cell id
+// as a covering with one cell. These 12 bytes are stored inline by DuckDB (i.e.,
+// without a heap allocation). Invalid cells are encoded as an empty point.
+class CellCenterEncoder {
+ public:
+  CellCenterEncoder() {
+    s2geography::EncodeTag tag;
+    tag.kind = s2geography::GeographyKind::CELL_CENTER;
+    tag.covering_size = 1;
+    Encoder non_empty(non_empty_, sizeof(non_empty_));
+    tag.Encode(&non_empty);
+
+    tag.kind = s2geography::GeographyKind::POINT;
+    tag.covering_size = 0;
+    tag.flags |= s2geography::EncodeTag::kFlagEmpty;
+    Encoder empty(empty_, sizeof(empty_));
+    tag.Encode(&empty);
+  }
+
+  string_t Encode(uint64_t cell_id) {
+    if (!S2CellId(cell_id).is_valid()) {
+      return string_t{empty_, sizeof(empty_)};
+    }
+
+    std::memcpy(non_empty_ + 4, &cell_id, sizeof(cell_id));
+    return string_t{non_empty_, sizeof(non_empty_)};
+  }
+
+ private:
+  char non_empty_[4 + sizeof(uint64_t)]{};
+  char empty_[4]{};
+};
+
+// Encodes points from coordinates (e.g., parsed without the WKT or WKB reader)
+// with the same result as the readers but without their overhead. A point is
+// stored as a cell center only if it is exactly the center of a leaf cell such
+// that no precision is lost.
+class ParsedPointEncoder {
+ public:
+  // Returns false for coordinates that are better left to the reader
+  bool TryEncode(const double* lnglat, GeographyEncoder& encoder, Vector& result,
+                 string_t* out) {
+    if (std::isnan(lnglat[0]) && std::isnan(lnglat[1])) {
+      *out = cell_encoder_.Encode(S2CellId::Sentinel().id());
+      return true;
+    }
+
+    if (!std::isfinite(lnglat[0]) || !std::isfinite(lnglat[1])) {
+      return false;
+    }
+
+    S2Point point = projection_.Unproject(R2Point(lnglat[0], lnglat[1]));
+    S2CellId cell(point);
+    if (cell.ToPoint() == point) {
+      *out = cell_encoder_.Encode(cell.id());
+    } else {
+      *out = encoder.Encode(s2geography::PointGeography(point), result);
+    }
+
+    return true;
+  }
+
+  // Same as TryEncode() but never leaves coordinates to a reader: coordinates
+  // that aren't finite are encoded as the point they project to
+  string_t Encode(const double* lnglat, GeographyEncoder& encoder, Vector& result) {
+    string_t out;
+    if (TryEncode(lnglat, encoder, result, &out)) {
+      return out;
+    }
+
+    S2Point point = projection_.Unproject(R2Point(lnglat[0], lnglat[1]));
+    return encoder.Encode(s2geography::PointGeography(point), result);
+  }
+
+ private:
+  // The projection used by the WKT and WKB readers
+  S2::PlateCarreeProjection projection_{180};
+  CellCenterEncoder cell_encoder_;
 };
 
 }  // namespace duckdb_s2
@@ -0,0 +1,12 @@
+#pragma once
+
+#include "duckdb/main/database.hpp"
+
+namespace duckdb {
+
+namespace duckdb_s2 {
+
+void RegisterS2Index(DatabaseInstance& instance);
+
+}
+}  // namespace duckdb
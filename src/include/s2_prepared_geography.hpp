@@ -0,0 +1,263 @@
+#pragma once
+
+#include "duckdb.hpp"
+#include "duckdb/execution/expression_executor.hpp"
+#include "duckdb/planner/expression/bound_function_expression.hpp"
+
+#include "s2/mutable_s2shape_index.h"
+#include "s2/s2cell_union.h"
+#include "s2/s2earth.h"
+#include "s2geography/geography.h"
+
+#include "s2_geography_serde.hpp"
+
+namespace duckdb {
+
+namespace duckdb_s2 {
+
+// A geography whose tag and covering have been decoded and that can be
+// decoded and indexed on demand for use in predicates and overlays. Once
+// Prepare() has been called, const access is thread safe such that a single
+// prepared geography can be shared among threads.
+class PreparedGeography {
+ public:
+  PreparedGeography() = default;
+
+  // Decode the tag and covering of data, which must outlive this object (or
+  // until the next call to Init())
+  PreparedGeography& Init(string_t data) {
+    index_.Clear();
+    index_ptr_ = nullptr;
+    geog_.reset();
+    interior_covering_decoded_ = false;
+
+    data_ = data;
+    decoder_.DecodeTagAndCovering(data_);
+    return *this;
+  }
+
+  // Like Init(), but take ownership of the bytes
+  PreparedGeography& InitOwned(std::string data) {
+    owned_data_ = std::move(data);
+    return Init(string_t(owned_data_));
+  }
+
+  bool IsEmpty() const { return decoder_.tag.flags & s2geography::EncodeTag::kFlagEmpty; }
+
+  s2geography::GeographyKind Kind() const {
+    return static_cast<s2geography::GeographyKind>(decoder_.tag.kind);
+  }
+
+  const std::vector<S2CellId>& Covering() const { return decoder_.covering; }
+
+  // Cells that are completely inside the geography (empty if none were stored),
+  // decoded the first time they are needed
+  const std::vector<S2CellId>& InteriorCovering() {
+    if (!interior_covering_decoded_) {
+      decoder_.DecodeInteriorCovering(data_);
+      interior_covering_decoded_ = true;
+    }
+
+    return decoder_.interior_covering;
+  }
+
+  // Only valid after Prepare() (or the non-const InteriorCovering())
+  const std::vector<S2CellId>& InteriorCovering() const {
+    D_ASSERT(interior_covering_decoded_);
+    return decoder_.interior_covering;
+  }
+
+  string_t Data() const { return data_; }
+
+  // Decode the geography (without building its index) if this has not already
+  // been done
+  const s2geography::Geography& Decode() {
+    if (!geog_) {
+      geog_ = decoder_.Decode(data_);
+    }
+
+    return *geog_;
+  }
+
+  // Decode the geography into storage owned by this object (reused from row to
+  // row) unless it has already been decoded. The result is valid until the next
+  // call to Init().
+  const s2geography::Geography& DecodeInPlace() {
+    if (geog_) {
+      return *geog_;
+    }
+
+    return decoder_.DecodeInPlace(data_);
+  }
+
+  // Decode the geography and build its index if this has not already been done.
+  // A geography that was already encoded with its index (i.e., the output of
+  // s2_prepare()) is used directly.
+  PreparedGeography& Prepare() {
+    if (index_ptr_ != nullptr) {
+      return *this;
+    }
+
+    InteriorCovering();
+    Decode();
+    if (geog_->kind() == s2geography::GeographyKind::ENCODED_SHAPE_INDEX) {
+      auto encoded_index =
+          reinterpret_cast<s2geography::EncodedShapeIndexGeography*>(geog_.get());
+      index_ptr_ = &encoded_index->ShapeIndex();
+    } else {
+      for (int i = 0; i < geog_->num_shapes(); i++) {
+        index_.Add(geog_->Shape(i));
+      }
+      index_.ForceBuild();
+      index_ptr_ = &index_;
+    }
+
+    return *this;
+  }
+
+  const s2geography::Geography& Geography() const {
+    D_ASSERT(geog_);
+    return *geog_;
+  }
+
+  const S2ShapeIndex& ShapeIndex() const {
+    D_ASSERT(index_ptr_ != nullptr);
+    return *index_ptr_;
+  }
+
+  // A rough estimate of the memory owned by this object. The decoded geography
+  // is assumed to be about the size of its encoded bytes.
+  idx_t MemoryUsage() const {
+    idx_t size = sizeof(PreparedGeography) + 2 * owned_data_.size();
+    if (index_ptr_ != nullptr) {
+      size += index_ptr_->SpaceUsed();
+    }
+
+    return size;
+  }
+
+ private:
+  GeographyDecoder decoder_;
+  std::string owned_data_;
+  string_t data_{""};
+  std::unique_ptr<s2geography::Geography> geog_;
+  MutableS2ShapeIndex index_;
+  const S2ShapeIndex* index_ptr_{nullptr};
+  bool interior_covering_decoded_{false};
+};
+
+// Expand a covering such that it contains every point within distance_meters
+// of the original. This is used to prefilter distance predicates in the same
+// way that the unexpanded covering is used to prefilter intersection.
+inline std::vector<S2CellId> ExpandCovering(const std::vector<S2CellId>& covering,
+                                            double distance_meters) {
+  // Don't use cells more than this many levels smaller than the largest cell
+  // in the covering
+  constexpr int kMaxLevelDiff = 4;
+
+  S2CellUnion cell_union(covering);
+  cell_union.Expand(S1Angle::Radians(distance_meters / S2Earth::RadiusMeters()),
+                    kMaxLevelDiff);
+  return cell_union.Release();
+}
+
+// Bind data for functions whose arguments may be constant: arguments that are
+// foldable are evaluated and prepared once at bind time and are shared
+// (read-only) among all threads executing the function.
+class PreparedArgsBindData : public FunctionData {
+ public:
+  explicit PreparedArgsBindData(idx_t num_args) : args(num_args) {}
+
+  vector<shared_ptr<PreparedGeography>> args;
+
+  // The prepared version of argument i or nullptr if that argument was not
+  // constant at bind time
+  static const PreparedGeography* Get(ExpressionState& state, idx_t i) {
+    auto& func_expr = state.expr.Cast<BoundFunctionExpression>();
+    if (!func_expr.bind_info) {
+      return nullptr;
+    }
+
+    auto& bind_data = func_expr.bind_info->Cast<PreparedArgsBindData>();
+    return bind_data.args[i].get();
+  }
+
+  unique_ptr<FunctionData> Copy() const override {
+    auto result = make_uniq<PreparedArgsBindData>(args.size());
+    result->args = args;
+    return std::move(result);
+  }
+
+  bool Equals(const FunctionData& other_p) const override {
+    auto& other = other_p.Cast<PreparedArgsBindData>();
+    if (args.size() != other.args.size()) {
+      return false;
+    }
+
+    for (idx_t i = 0; i < args.size(); i++) {
+      if (!args[i] || !other.args[i]) {
+        if (args[i] != other.args[i]) {
+          return false;
+        }
+      } else if (!(args[i]->Data() == other.args[i]->Data())) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+};
+
+inline unique_ptr<FunctionData> BindPreparedArgs(
+    ClientContext& context, ScalarFunction& bound_function,
+    vector<unique_ptr<Expression>>& arguments) {
+  auto result = make_uniq<PreparedArgsBindData>(arguments.size());
+  for (idx_t i = 0; i < arguments.size(); i++) {
+    if (arguments[i]->return_type.id() != LogicalTypeId::BLOB ||
+        !arguments[i]->IsFoldable()) {
+      continue;
+    }
+
+    Value value = ExpressionExecutor::EvaluateScalar(context, *arguments[i]);
+    if (value.IsNull()) {
+      continue;
+    }
+
+    auto prepared = make_shared_ptr<PreparedGeography>();
+    prepared->InitOwned(StringValue::Get(value));
+    if (!prepared->IsEmpty()) {
+      prepared->Prepare();
+    }
+
+    result->args[i] = std::move(prepared);
+  }
+
+  return std::move(result);
+}
+
+// Resolve an argument of a function that was bound with BindPreparedArgs():
+// if the argument was constant at bind time, use that; otherwise, if it is a
+// constant vector, prepare it once for the whole chunk. Returns nullptr if the
+// argument needs to be prepared row by row.
+inline const PreparedGeography* GetConstantArg(ExpressionState& state, Vector& arg,
+                                               idx_t i, PreparedGeography& scratch) {
+  auto bound = PreparedArgsBindData::Get(state, i);
+  if (bound) {
+    return bound;
+  }
+
+  if (arg.GetVectorType() == VectorType::CONSTANT_VECTOR &&
+      !ConstantVector::IsNull(arg)) {
+    scratch.Init(ConstantVector::GetData<string_t>(arg)[0]);
+    if (!scratch.IsEmpty()) {
+      scratch.Prepare();
+    }
+
+    return &scratch;
+  }
+
+  return nullptr;
+}
+
+}  // namespace duckdb_s2
+}  // namespace duckdb
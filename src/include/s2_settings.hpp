@@ -0,0 +1,42 @@
+#pragma once
+
+#include "duckdb/main/client_context.hpp"
+#include "duckdb/main/database.hpp"
+
+#include "s2/encoded_s2point_vector.h"
+#include "s2/mutable_s2shape_index.h"
+#include "s2/s2region_coverer.h"
+
+#include "s2_geography_serde.hpp"
+
+namespace duckdb {
+
+namespace duckdb_s2 {
+
+// The maximum number of bytes each thread may use to cache decoded and
+// indexed geographies for a single function call (s2_cache_memory_limit)
+idx_t GetCacheMemoryLimit(ClientContext& context);
+
+// The coding hint used to encode new GEOGRAPHY values (s2_coding_hint)
+s2coding::CodingHint GetCodingHint(ClientContext& context);
+
+// Set up encoder to encode new GEOGRAPHY values with the current settings
+// (s2_coding_hint, s2_encode_extensions, s2_encode_interior_covering,
+// s2_covering_max_cells, s2_covering_max_level)
+void InitGeographyEncoder(ClientContext& context, GeographyEncoder* encoder);
+
+// Options for s2_covering() and the covering stored with new GEOGRAPHY values
+// (s2_covering_max_cells, s2_covering_max_level)
+void InitCovererOptions(ClientContext& context, S2RegionCoverer::Options* options);
+
+// The encoded size below which s2_prepare() doesn't build an index
+// (s2_prepare_threshold)
+idx_t GetPrepareThreshold(ClientContext& context);
+
+// Options for indexes built by s2_prepare() (s2_index_max_edges_per_cell)
+void InitShapeIndexOptions(ClientContext& context, MutableS2ShapeIndex::Options* options);
+
+void RegisterSettings(DatabaseInstance& instance);
+
+}  // namespace duckdb_s2
+}  // namespace duckdb
@@ -8,6 +8,7 @@
 #include "s2geography/accessors.h"
 
 #include "s2/s2cell_union.h"
+#include "s2_executor.hpp"
 #include "s2_geography_serde.hpp"
 #include "s2_types.hpp"
 
@@ -55,6 +56,7 @@ struct S2Area {
       func.AddVariant([](ScalarFunctionVariantBuilder& variant) {
         variant.AddParameter("geog", Types::GEOGRAPHY());
         variant.SetReturnType(LogicalType::DOUBLE);
+        variant.SetLocalState<GeographyDecoder>();
         variant.SetFunction(ExecuteFn);
       });
 
@@ -78,13 +80,13 @@ SELECT s2_area('POINT (0 0)'::GEOGRAPHY) AS area;
   }
 
   static inline void ExecuteFn(DataChunk& args, ExpressionState& state, Vector& result) {
-    Execute(args.data[0], result, args.size());
+    auto& decoder = ScalarFunctionLocalState<GeographyDecoder>::Get(state);
+    Execute(args.data[0], result, args.size(), decoder);
   }
 
-  static void Execute(Vector& source, Vector& result, idx_t count) {
-    GeographyDecoder decoder;
-
-    UnaryExecutor::Execute<string_t, double>(
+  static void Execute(Vector& source, Vector& result, idx_t count,
+                      GeographyDecoder& decoder) {
+    GeographyExecutor::ExecuteUnary<string_t, double>(
         source, result, count, [&](string_t geog_str) {
           decoder.DecodeTag(geog_str);
 
@@ -98,8 +100,8 @@ SELECT s2_area('POINT (0 0)'::GEOGRAPHY) AS area;
             case s2geography::GeographyKind::POLYLINE:
               return 0.0;
             default: {
-              auto geog = decoder.Decode(geog_str);
-              return s2geography::s2_area(*geog) * S2Earth::RadiusMeters() *
+              auto& geog = decoder.DecodeInPlace(geog_str);
+              return s2geography::s2_area(geog) * S2Earth::RadiusMeters() *
                      S2Earth::RadiusMeters();
             }
           }
@@ -114,7 +116,8 @@ struct S2Perimieter {
           func.AddVariant([](ScalarFunctionVariantBuilder& variant) {
             variant.AddParameter("geog", Types::GEOGRAPHY());
             variant.SetReturnType(LogicalType::DOUBLE);
-            variant.SetFunction(ExecuteFn);
+            variant.SetLocalState<GeographyDecoder>();
+        variant.SetFunction(ExecuteFn);
           });
 
           func.SetDescription(R"(
@@ -139,13 +142,13 @@ SELECT s2_perimeter('POINT (0 0)'::GEOGRAPHY) AS perimeter;
   }
 
   static inline void ExecuteFn(DataChunk& args, ExpressionState& state, Vector& result) {
-    Execute(args.data[0], result, args.size());
+    auto& decoder = ScalarFunctionLocalState<GeographyDecoder>::Get(state);
+    Execute(args.data[0], result, args.size(), decoder);
   }
 
-  static void Execute(Vector& source, Vector& result, idx_t count) {
-    GeographyDecoder decoder;
-
-    UnaryExecutor::Execute<string_t, double>(
+  static void Execute(Vector& source, Vector& result, idx_t count,
+                      GeographyDecoder& decoder) {
+    GeographyExecutor::ExecuteUnary<string_t, double>(
         source, result, count, [&](string_t geog_str) {
           decoder.DecodeTag(geog_str);
           if (decoder.tag.flags & s2geography::EncodeTag::kFlagEmpty) {
@@ -158,8 +161,8 @@ SELECT s2_perimeter('POINT (0 0)'::GEOGRAPHY) AS perimeter;
             case s2geography::GeographyKind::POLYLINE:
               return 0.0;
             default: {
-              auto geog = decoder.Decode(geog_str);
-              return s2geography::s2_perimeter(*geog) * S2Earth::RadiusMeters();
+              auto& geog = decoder.DecodeInPlace(geog_str);
+              return s2geography::s2_perimeter(geog) * S2Earth::RadiusMeters();
             }
           }
         });
@@ -173,7 +176,8 @@ struct S2Length {
           func.AddVariant([](ScalarFunctionVariantBuilder& variant) {
             variant.AddParameter("geog", Types::GEOGRAPHY());
             variant.SetReturnType(LogicalType::DOUBLE);
-            variant.SetFunction(ExecuteFn);
+            variant.SetLocalState<GeographyDecoder>();
+        variant.SetFunction(ExecuteFn);
           });
 
           func.SetDescription(R"(
@@ -195,13 +199,13 @@ SELECT s2_length(s2_data_country('Canada')) AS length;
   }
 
   static inline void ExecuteFn(DataChunk& args, ExpressionState& state, Vector& result) {
-    Execute(args.data[0], result, args.size());
+    auto& decoder = ScalarFunctionLocalState<GeographyDecoder>::Get(state);
+    Execute(args.data[0], result, args.size(), decoder);
   }
 
-  static void Execute(Vector& source, Vector& result, idx_t count) {
-    GeographyDecoder decoder;
-
-    UnaryExecutor::Execute<string_t, double>(
+  static void Execute(Vector& source, Vector& result, idx_t count,
+                      GeographyDecoder& decoder) {
+    GeographyExecutor::ExecuteUnary<string_t, double>(
         source, result, count, [&](string_t geog_str) {
           decoder.DecodeTag(geog_str);
 
@@ -215,8 +219,8 @@ SELECT s2_length(s2_data_country('Canada')) AS length;
             case s2geography::GeographyKind::POLYGON:
               return 0.0;
             default: {
-              auto geog = decoder.Decode(geog_str);
-              return s2geography::s2_length(*geog) * S2Earth::RadiusMeters();
+              auto& geog = decoder.DecodeInPlace(geog_str);
+              return s2geography::s2_length(geog) * S2Earth::RadiusMeters();
             }
           }
         });
@@ -229,6 +233,7 @@ struct S2XY {
       func.AddVariant([](ScalarFunctionVariantBuilder& variant) {
         variant.AddParameter("geog", Types::GEOGRAPHY());
         variant.SetReturnType(LogicalType::DOUBLE);
+        variant.SetLocalState<GeographyDecoder>();
         variant.SetFunction(ExecuteFnX);
       });
 
@@ -250,6 +255,7 @@ SELECT s2_x('POINT (-64 45)'::GEOGRAPHY);
       func.AddVariant([](ScalarFunctionVariantBuilder& variant) {
         variant.AddParameter("geog", Types::GEOGRAPHY());
         variant.SetReturnType(LogicalType::DOUBLE);
+        variant.SetLocalState<GeographyDecoder>();
         variant.SetFunction(ExecuteFnY);
       });
 
@@ -269,23 +275,26 @@ SELECT s2_y('POINT (-64 45)'::GEOGRAPHY);
   }
 
   static inline void ExecuteFnX(DataChunk& args, ExpressionState& state, Vector& result) {
+    auto& decoder = ScalarFunctionLocalState<GeographyDecoder>::Get(state);
     Execute(
-        args.data[0], result, args.size(), [](S2LatLng ll) { return ll.lng().degrees(); },
+        args.data[0], result, args.size(), decoder,
+        [](S2LatLng ll) { return ll.lng().degrees(); },
         [](const s2geography::Geography& geog) { return s2_x(geog); });
   }
 
   static inline void ExecuteFnY(DataChunk& args, ExpressionState& state, Vector& result) {
+    auto& decoder = ScalarFunctionLocalState<GeographyDecoder>::Get(state);
     Execute(
-        args.data[0], result, args.size(), [](S2LatLng ll) { return ll.lat().degrees(); },
+        args.data[0], result, args.size(), decoder,
+        [](S2LatLng ll) { return ll.lat().degrees(); },
         [](const s2geography::Geography& geog) { return s2_y(geog); });
   }
 
   template <typename HandleLatLng, typename HandleGeog>
   static void Execute(Vector& source, Vector& result, idx_t count,
-                      HandleLatLng&& handle_latlng, HandleGeog&& handle_geog) {
-    GeographyDecoder decoder;
-
-    UnaryExecutor::Execute<string_t, double>(
+                      GeographyDecoder& decoder, HandleLatLng&& handle_latlng,
+                      HandleGeog&& handle_geog) {
+    GeographyExecutor::ExecuteUnary<string_t, double>(
         source, result, count, [&](string_t geog_str) {
           decoder.DecodeTag(geog_str);
 
@@ -301,8 +310,7 @@ SELECT s2_y('POINT (-64 45)'::GEOGRAPHY);
             }
 
             default: {
-              auto geog = decoder.Decode(geog_str);
-              return handle_geog(*geog);
+              return handle_geog(decoder.DecodeInPlace(geog_str));
             }
           }
         });
@@ -1,15 +1,26 @@
 
+#include <algorithm>
+
+#include "duckdb/execution/expression_executor_state.hpp"
 #include "duckdb/main/database.hpp"
 #include "duckdb/main/extension_util.hpp"
 
 #include "s2/s2cell_union.h"
+#include "s2/s2closest_edge_query.h"
+#include "s2/s2contains_point_query.h"
+#include "s2/s2earth.h"
+#include "s2/s2furthest_edge_query.h"
+#include "s2/s2predicates.h"
+#include "s2_geography_cache.hpp"
 #include "s2_geography_serde.hpp"
+#include "s2_prepared_geography.hpp"
 #include "s2_types.hpp"
 
 #include "s2geography/build.h"
 
 #include "function_builder.hpp"
 #include "global_options.hpp"
+#include "s2_settings.hpp"
 
 namespace duckdb {
 
@@ -25,6 +36,8 @@ struct S2BinaryIndexOp {
             variant.AddParameter("geog1", Types::GEOGRAPHY());
             variant.AddParameter("geog2", Types::GEOGRAPHY());
             variant.SetReturnType(LogicalType::BOOLEAN);
+            variant.SetBind(BindPreparedArgs);
+            variant.SetLocalState<BinaryOpLocalState>();
             variant.SetFunction(ExecuteMayIntersectFn);
           });
 
@@ -56,6 +69,8 @@ SELECT s2_mayintersect(s2_data_country('Canada'), s2_data_city('Berlin'));
             variant.AddParameter("geog1", Types::GEOGRAPHY());
             variant.AddParameter("geog2", Types::GEOGRAPHY());
             variant.SetReturnType(LogicalType::BOOLEAN);
+            variant.SetBind(BindPreparedArgs);
+            variant.SetLocalState<BinaryOpLocalState>();
             variant.SetFunction(ExecuteIntersectsFn);
           });
 
@@ -79,6 +94,8 @@ SELECT s2_intersects(s2_data_country('Canada'), s2_data_city('Chicago'));
             variant.AddParameter("geog1", Types::GEOGRAPHY());
             variant.AddParameter("geog2", Types::GEOGRAPHY());
             variant.SetReturnType(LogicalType::BOOLEAN);
+            variant.SetBind(BindPreparedArgs);
+            variant.SetLocalState<BinaryOpLocalState>();
             variant.SetFunction(ExecuteContainsFn);
           });
 
@@ -104,6 +121,8 @@ SELECT s2_contains(s2_data_country('Canada'), s2_data_city('Chicago'));
             variant.AddParameter("geog1", Types::GEOGRAPHY());
             variant.AddParameter("geog2", Types::GEOGRAPHY());
             variant.SetReturnType(LogicalType::BOOLEAN);
+            variant.SetBind(BindPreparedArgs);
+            variant.SetLocalState<BinaryOpLocalState>();
             variant.SetFunction(ExecuteEqualsFn);
           });
 
@@ -123,12 +142,103 @@ SELECT s2_equals(s2_data_city('Toronto'), s2_data_country('Canada'));
           func.SetTag("category", "predicates");
         });
 
+    FunctionBuilder::RegisterScalar(
+        instance, "s2_dwithin", [](ScalarFunctionBuilder& func) {
+          func.AddVariant([](ScalarFunctionVariantBuilder& variant) {
+            variant.AddParameter("geog1", Types::GEOGRAPHY());
+            variant.AddParameter("geog2", Types::GEOGRAPHY());
+            variant.AddParameter("distance", LogicalType::DOUBLE);
+            variant.SetReturnType(LogicalType::BOOLEAN);
+            variant.SetBind(BindPreparedArgs);
+            variant.SetLocalState<BinaryOpLocalState>();
+            variant.SetFunction(ExecuteDWithinFn);
+          });
+
+          func.SetDescription(R"(
+Returns true if the distance between two geographies is less than or equal
+to `distance` (in meters).
+
+The internal [covering](#s2_covering) of the first geography is expanded
+by `distance` to cheaply reject geographies that are definitely too far apart
+before the exact distance is checked. Inner joins on this predicate with a
+constant distance are planned as a spatial join.
+)");
+
+          func.SetExample(R"(
+SELECT s2_dwithin(s2_data_city('Toronto'), s2_data_city('Ottawa'), 400000);
+----
+SELECT s2_dwithin(s2_data_city('Toronto'), s2_data_city('Ottawa'), 300000);
+)");
+
+          func.SetTag("ext", "geography");
+          func.SetTag("category", "predicates");
+        });
+
+    FunctionBuilder::RegisterScalar(
+        instance, "s2_distance", [](ScalarFunctionBuilder& func) {
+          func.AddVariant([](ScalarFunctionVariantBuilder& variant) {
+            variant.AddParameter("geog1", Types::GEOGRAPHY());
+            variant.AddParameter("geog2", Types::GEOGRAPHY());
+            variant.SetReturnType(LogicalType::DOUBLE);
+            variant.SetBind(BindPreparedArgs);
+            variant.SetLocalState<BinaryOpLocalState>();
+            variant.SetFunction(ExecuteDistanceFn);
+          });
+
+          func.SetDescription(R"(
+Returns the minimum distance between two geographies in meters.
+
+The distance is zero if the geographies intersect (including if one is
+contained by the other) and NULL if either geography is empty.
+)");
+
+          func.SetExample(R"(
+SELECT s2_distance(s2_data_city('Toronto'), s2_data_city('Ottawa'));
+----
+SELECT name, s2_distance(geog, s2_data_city('Toronto')) AS distance
+FROM s2_data_cities()
+ORDER BY distance
+LIMIT 5;
+)");
+
+          func.SetTag("ext", "geography");
+          func.SetTag("category", "accessors");
+        });
+
+    FunctionBuilder::RegisterScalar(
+        instance, "s2_max_distance", [](ScalarFunctionBuilder& func) {
+          func.AddVariant([](ScalarFunctionVariantBuilder& variant) {
+            variant.AddParameter("geog1", Types::GEOGRAPHY());
+            variant.AddParameter("geog2", Types::GEOGRAPHY());
+            variant.SetReturnType(LogicalType::DOUBLE);
+            variant.SetBind(BindPreparedArgs);
+            variant.SetLocalState<BinaryOpLocalState>();
+            variant.SetFunction(ExecuteMaxDistanceFn);
+          });
+
+          func.SetDescription(R"(
+Returns the maximum distance between two geographies in meters.
+
+This is the distance between the two points (one on each geography) that are
+furthest apart. It is NULL if either geography is empty.
+)");
+
+          func.SetExample(R"(
+SELECT s2_max_distance(s2_data_city('Toronto'), s2_data_country('Canada'));
+)");
+
+          func.SetTag("ext", "geography");
+          func.SetTag("category", "accessors");
+        });
+
     FunctionBuilder::RegisterScalar(
         instance, "s2_intersection", [](ScalarFunctionBuilder& func) {
           func.AddVariant([](ScalarFunctionVariantBuilder& variant) {
             variant.AddParameter("geog1", Types::GEOGRAPHY());
             variant.AddParameter("geog2", Types::GEOGRAPHY());
             variant.SetReturnType(Types::GEOGRAPHY());
+            variant.SetBind(BindPreparedArgs);
+            variant.SetLocalState<BinaryOpLocalState>();
             variant.SetFunction(ExecuteIntersectionFn);
           });
 
@@ -153,6 +263,8 @@ SELECT s2_intersection(
             variant.AddParameter("geog1", Types::GEOGRAPHY());
             variant.AddParameter("geog2", Types::GEOGRAPHY());
             variant.SetReturnType(Types::GEOGRAPHY());
+            variant.SetBind(BindPreparedArgs);
+            variant.SetLocalState<BinaryOpLocalState>();
             variant.SetFunction(ExecuteDifferenceFn);
           });
 
@@ -177,6 +289,8 @@ SELECT s2_difference(
             variant.AddParameter("geog1", Types::GEOGRAPHY());
             variant.AddParameter("geog2", Types::GEOGRAPHY());
             variant.SetReturnType(Types::GEOGRAPHY());
+            variant.SetBind(BindPreparedArgs);
+            variant.SetLocalState<BinaryOpLocalState>();
             variant.SetFunction(ExecuteUnionFn);
           });
 
@@ -196,268 +310,690 @@ SELECT s2_union(
         });
   }
 
-  using UniqueGeography = std::unique_ptr<s2geography::Geography>;
+  // Each thread keeps everything needed to evaluate a predicate or overlay such
+  // that it (and any buffers it owns) is reused for every chunk: for each
+  // argument, a cache of decoded and indexed geographies such that repeated
+  // values (e.g., the polygon side of a join) are only decoded and indexed once
+  // (the memory limit is split between the two arguments) and scratch space for
+  // the current row, plus the options and encoder used to compute the result.
+  class BinaryOpLocalState {
+   public:
+    struct Arg {
+      explicit Arg(idx_t memory_limit) : cache(memory_limit) {}
+
+      GeographyCache cache;
+      PreparedGeography scratch;
+      PreparedGeography row;
+      std::vector<S2Point> points;
+    };
+
+    explicit BinaryOpLocalState(ClientContext& context)
+        : lhs(GetCacheMemoryLimit(context) / 2), rhs(GetCacheMemoryLimit(context) / 2) {
+      InitGeographyEncoder(context, &encoder);
+      InitBooleanOperationOptions(&boolean_options);
+      InitGlobalOptions(&global_options);
+      closest_edge_options.set_include_interiors(true);
+      furthest_edge_options.set_include_interiors(true);
+    }
 
-  static void ExecuteMayIntersectFn(DataChunk& args, ExpressionState& state,
-                                    Vector& result) {
-    return ExecutePredicateFn(
-        args, state, result,
-        [](UniqueGeography lhs, UniqueGeography rhs) { return true; });
-  }
+    Arg lhs;
+    Arg rhs;
+    GeographyEncoder encoder;
+    S2BooleanOperation::Options boolean_options;
+    s2geography::GlobalOptions global_options;
+    S2ClosestEdgeQuery::Options closest_edge_options;
+    S2FurthestEdgeQuery::Options furthest_edge_options;
+    S2ClosestEdgeQuery closest_edge_query;
+    S2FurthestEdgeQuery furthest_edge_query;
+    std::vector<S2CellId> intersection;
 
-  // Handle the case where we've already computed the index on one or both
-  // of the sides in advance
-  template <typename ShapeIndexFilter>
-  static auto DispatchShapeIndexFilter(UniqueGeography lhs, UniqueGeography rhs,
-                                       ShapeIndexFilter&& filter) {
-    if (lhs->kind() == s2geography::GeographyKind::ENCODED_SHAPE_INDEX &&
-        rhs->kind() == s2geography::GeographyKind::ENCODED_SHAPE_INDEX) {
-      auto lhs_index =
-          reinterpret_cast<s2geography::EncodedShapeIndexGeography*>(lhs.get());
-      auto rhs_index =
-          reinterpret_cast<s2geography::EncodedShapeIndexGeography*>(rhs.get());
-      return filter(lhs_index->ShapeIndex(), rhs_index->ShapeIndex());
-    } else if (lhs->kind() == s2geography::GeographyKind::ENCODED_SHAPE_INDEX) {
-      auto lhs_index =
-          reinterpret_cast<s2geography::EncodedShapeIndexGeography*>(lhs.get());
-      s2geography::ShapeIndexGeography rhs_index(*rhs);
-      return filter(lhs_index->ShapeIndex(), rhs_index.ShapeIndex());
-    } else if (rhs->kind() == s2geography::GeographyKind::ENCODED_SHAPE_INDEX) {
-      s2geography::ShapeIndexGeography lhs_index(*lhs);
-      auto rhs_index =
-          reinterpret_cast<s2geography::EncodedShapeIndexGeography*>(rhs.get());
-      return filter(lhs_index.ShapeIndex(), rhs_index->ShapeIndex());
-    } else {
-      s2geography::ShapeIndexGeography lhs_index(*lhs);
-      s2geography::ShapeIndexGeography rhs_index(*rhs);
-      return filter(lhs_index.ShapeIndex(), rhs_index.ShapeIndex());
+    static BinaryOpLocalState& Get(ExpressionState& state) {
+      return ScalarFunctionLocalState<BinaryOpLocalState>::Get(state);
+    }
+  };
+
+  // The state of one argument for a chunk: either a geography that was
+  // prepared in advance (at bind time or once for a constant vector) or the
+  // geography for the current row, which is only decoded and indexed if
+  // it is needed (or looked up in the cache).
+  class ArgState {
+   public:
+    ArgState(ExpressionState& state, BinaryOpLocalState::Arg& local, Vector& arg, idx_t i)
+        : constant_(GetConstantArg(state, arg, i, local.scratch)),
+          row_(local.row),
+          cache_(local.cache),
+          points_(local.points) {}
+
+    const PreparedGeography& Init(string_t data) {
+      return constant_ ? *constant_ : row_.Init(data);
     }
+
+    bool IsConstant() const { return constant_ != nullptr; }
+
+    const PreparedGeography& Current() const { return constant_ ? *constant_ : row_; }
+
+    bool IsPoint() const { return IsPointKind(Current().Kind()); }
+
+    const std::vector<S2CellId>& InteriorCovering() {
+      return constant_ ? constant_->InteriorCovering() : row_.InteriorCovering();
+    }
+
+    // The points of a POINT or CELL_CENTER geography, which never requires
+    // building an index
+    const std::vector<S2Point>& Points() {
+      points_.clear();
+      if (Current().Kind() == s2geography::GeographyKind::CELL_CENTER) {
+        points_.push_back(Current().Covering()[0].ToPoint());
+        return points_;
+      }
+
+      const s2geography::Geography& geog =
+          constant_ ? constant_->Geography() : row_.DecodeInPlace();
+      return static_cast<const s2geography::PointGeography&>(geog).Points();
+    }
+
+    const S2ShapeIndex& ShapeIndex() {
+      if (constant_) {
+        return constant_->ShapeIndex();
+      } else if (IsWorthCaching(row_)) {
+        return cache_.Prepare(row_.Data()).ShapeIndex();
+      } else {
+        return row_.Prepare().ShapeIndex();
+      }
+    }
+
+   private:
+    const PreparedGeography* constant_;
+    PreparedGeography& row_;
+    GeographyCache& cache_;
+    std::vector<S2Point>& points_;
+
+    static bool IsPointKind(s2geography::GeographyKind kind) {
+      return kind == s2geography::GeographyKind::POINT ||
+             kind == s2geography::GeographyKind::CELL_CENTER;
+    }
+
+    // Points are cheaper to decode than to look up
+    static bool IsWorthCaching(const PreparedGeography& geog) {
+      return !IsPointKind(geog.Kind());
+    }
+  };
+
+  static void ExecuteMayIntersectFn(DataChunk& args, ExpressionState& state,
+                                    Vector& result) {
+    return ExecutePredicateFn(args, state, result,
+                              [](ArgState& lhs, ArgState& rhs) { return true; });
   }
 
   static void ExecuteIntersectsFn(DataChunk& args, ExpressionState& state,
                                   Vector& result) {
-    S2BooleanOperation::Options options;
-    InitBooleanOperationOptions(&options);
+    auto& options = BinaryOpLocalState::Get(state).boolean_options;
 
     return ExecutePredicateFn(
-        args, state, result, [&options](UniqueGeography lhs, UniqueGeography rhs) {
-          return DispatchShapeIndexFilter(
-              std::move(lhs), std::move(rhs),
-              [&options](const S2ShapeIndex& lhs_index, const S2ShapeIndex& rhs_index) {
-                return S2BooleanOperation::Intersects(lhs_index, rhs_index, options);
-              });
+        args, state, result, [&options](ArgState& lhs, ArgState& rhs) {
+          return DispatchPredicate<IntersectsOp>(lhs, rhs, options);
         });
   }
 
   static void ExecuteContainsFn(DataChunk& args, ExpressionState& state, Vector& result) {
-    // Note: Polygon containment when there is a partial shared edge might
-    // need to be calculated differently.
-    S2BooleanOperation::Options options;
-    InitBooleanOperationOptions(&options);
+    auto& options = BinaryOpLocalState::Get(state).boolean_options;
 
     return ExecutePredicateFn(
-        args, state, result, [&options](UniqueGeography lhs, UniqueGeography rhs) {
-          return DispatchShapeIndexFilter(
-              std::move(lhs), std::move(rhs),
-              [&options](const S2ShapeIndex& lhs_index, const S2ShapeIndex& rhs_index) {
-                return S2BooleanOperation::Contains(lhs_index, rhs_index, options);
-              });
+        args, state, result, [&options](ArgState& lhs, ArgState& rhs) {
+          return DispatchPredicate<ContainsOp>(lhs, rhs, options);
         });
   }
 
   static void ExecuteEqualsFn(DataChunk& args, ExpressionState& state, Vector& result) {
-    S2BooleanOperation::Options options;
-    InitBooleanOperationOptions(&options);
+    auto& options = BinaryOpLocalState::Get(state).boolean_options;
 
     return ExecutePredicateFn(
-        args, state, result, [&options](UniqueGeography lhs, UniqueGeography rhs) {
-          return DispatchShapeIndexFilter(
-              std::move(lhs), std::move(rhs),
-              [&options](const S2ShapeIndex& lhs_index, const S2ShapeIndex& rhs_index) {
-                return S2BooleanOperation::Equals(lhs_index, rhs_index, options);
-              });
+        args, state, result, [&options](ArgState& lhs, ArgState& rhs) {
+          return S2BooleanOperation::Equals(lhs.ShapeIndex(), rhs.ShapeIndex(), options);
         });
   }
 
+  static void ExecuteDWithinFn(DataChunk& args, ExpressionState& state, Vector& result) {
+    auto& local = BinaryOpLocalState::Get(state);
+    ArgState lhs_arg(state, local.lhs, args.data[0], 0);
+    ArgState rhs_arg(state, local.rhs, args.data[1], 1);
+    auto& intersection = local.intersection;
+
+    // When the lefthand side is constant, its expanded covering only needs to
+    // be recomputed when the distance changes
+    std::vector<S2CellId> expanded;
+    double expanded_distance = -1;
+
+    auto& options = local.closest_edge_options;
+
+    TernaryExecutor::Execute<string_t, string_t, double, bool>(
+        args.data[0], args.data[1], args.data[2], result, args.size(),
+        [&](string_t lhs_str, string_t rhs_str, double distance) {
+          if (distance < 0) {
+            return false;
+          }
+
+          auto& lhs_geog = lhs_arg.Init(lhs_str);
+          if (lhs_geog.IsEmpty()) {
+            return false;
+          }
+
+          auto& rhs_geog = rhs_arg.Init(rhs_str);
+          if (rhs_geog.IsEmpty()) {
+            return false;
+          }
+
+          if (!lhs_geog.Covering().empty() && !rhs_geog.Covering().empty()) {
+            if (!lhs_arg.IsConstant() || distance != expanded_distance) {
+              expanded = ExpandCovering(lhs_geog.Covering(), distance);
+              expanded_distance = distance;
+            }
+
+            S2CellUnion::GetIntersection(expanded, rhs_geog.Covering(), &intersection);
+            if (intersection.empty()) {
+              return false;
+            }
+          }
+
+          S2ClosestEdgeQuery query(&lhs_arg.ShapeIndex(), options);
+          S2ClosestEdgeQuery::ShapeIndexTarget target(&rhs_arg.ShapeIndex());
+          target.set_include_interiors(true);
+          return query.IsDistanceLessOrEqual(
+              &target,
+              S1ChordAngle(S1Angle::Radians(distance / S2Earth::RadiusMeters())));
+        });
+  }
+
+  static void ExecuteDistanceFn(DataChunk& args, ExpressionState& state, Vector& result) {
+    auto& local = BinaryOpLocalState::Get(state);
+    ExecuteDistance(args, state, result, local.closest_edge_query,
+                    local.closest_edge_options);
+  }
+
+  static void ExecuteMaxDistanceFn(DataChunk& args, ExpressionState& state,
+                                   Vector& result) {
+    auto& local = BinaryOpLocalState::Get(state);
+    ExecuteDistance(args, state, result, local.furthest_edge_query,
+                    local.furthest_edge_options);
+  }
+
+  // Distances are symmetric, so the side that is used as the index of the query
+  // is the constant one (whose query is only initialized once for the chunk) or
+  // otherwise the one that isn't a point, such that a single point is always a
+  // PointTarget that doesn't need an index. Two single points don't need a query
+  // at all.
+  template <typename Query>
+  static void ExecuteDistance(DataChunk& args, ExpressionState& state, Vector& result,
+                              Query& query, const typename Query::Options& options) {
+    auto& local = BinaryOpLocalState::Get(state);
+    ArgState lhs_arg(state, local.lhs, args.data[0], 0);
+    ArgState rhs_arg(state, local.rhs, args.data[1], 1);
+    bool query_initialized = false;
+
+    BinaryExecutor::ExecuteWithNulls<string_t, string_t, double>(
+        args.data[0], args.data[1], result, args.size(),
+        [&](string_t lhs_str, string_t rhs_str, ValidityMask& mask, idx_t i) {
+          auto& lhs_geog = lhs_arg.Init(lhs_str);
+          auto& rhs_geog = rhs_arg.Init(rhs_str);
+          if (lhs_geog.IsEmpty() || rhs_geog.IsEmpty()) {
+            mask.SetInvalid(i);
+            return 0.0;
+          }
+
+          bool rhs_is_index;
+          if (lhs_arg.IsConstant() || rhs_arg.IsConstant()) {
+            rhs_is_index = !lhs_arg.IsConstant();
+          } else {
+            rhs_is_index = lhs_arg.IsPoint() && !rhs_arg.IsPoint();
+          }
+
+          ArgState& index_arg = rhs_is_index ? rhs_arg : lhs_arg;
+          ArgState& target_arg = rhs_is_index ? lhs_arg : rhs_arg;
+
+          const S2Point* target_point = nullptr;
+          if (target_arg.IsPoint()) {
+            const std::vector<S2Point>& points = target_arg.Points();
+            if (points.size() == 1) {
+              target_point = &points[0];
+            }
+          }
+
+          if (target_point != nullptr && index_arg.IsPoint()) {
+            const std::vector<S2Point>& points = index_arg.Points();
+            if (points.size() == 1) {
+              return ToMeters(S1ChordAngle(points[0], *target_point));
+            }
+          }
+
+          if (!query_initialized || !index_arg.IsConstant()) {
+            query.Init(&index_arg.ShapeIndex(), options);
+            query_initialized = true;
+          }
+
+          if (target_point != nullptr) {
+            typename Query::PointTarget target(*target_point);
+            return ToMeters(query.GetDistance(&target));
+          }
+
+          typename Query::ShapeIndexTarget target(&target_arg.ShapeIndex());
+          target.set_include_interiors(true);
+          return ToMeters(query.GetDistance(&target));
+        });
+  }
+
+  static double ToMeters(S1ChordAngle angle) {
+    return angle.ToAngle().radians() * S2Earth::RadiusMeters();
+  }
+
   template <typename Filter>
   static void ExecutePredicateFn(DataChunk& args, ExpressionState& state, Vector& result,
                                  Filter&& filter) {
-    ExecutePredicate(args.data[0], args.data[1], result, args.size(), filter);
+    ExecutePredicate(state, args.data[0], args.data[1], result, args.size(), filter);
   }
 
   template <typename Filter>
-  static void ExecutePredicate(Vector& lhs, Vector& rhs, Vector& result, idx_t count,
-                               Filter&& filter) {
-    GeographyDecoder lhs_decoder;
-    GeographyDecoder rhs_decoder;
-    std::vector<S2CellId> intersection;
+  static void ExecutePredicate(ExpressionState& state, Vector& lhs, Vector& rhs,
+                               Vector& result, idx_t count, Filter&& filter) {
+    auto& local = BinaryOpLocalState::Get(state);
+    ArgState lhs_arg(state, local.lhs, lhs, 0);
+    ArgState rhs_arg(state, local.rhs, rhs, 1);
+    auto& intersection = local.intersection;
 
     BinaryExecutor::Execute<string_t, string_t, bool>(
         lhs, rhs, result, count, [&](string_t lhs_str, string_t rhs_str) {
-          lhs_decoder.DecodeTagAndCovering(lhs_str);
-          if (lhs_decoder.tag.flags & s2geography::EncodeTag::kFlagEmpty) {
+          auto& lhs_geog = lhs_arg.Init(lhs_str);
+          if (lhs_geog.IsEmpty()) {
             return false;
           }
 
-          rhs_decoder.DecodeTagAndCovering(rhs_str);
-          if (rhs_decoder.tag.flags & s2geography::EncodeTag::kFlagEmpty) {
+          auto& rhs_geog = rhs_arg.Init(rhs_str);
+          if (rhs_geog.IsEmpty()) {
             return false;
           }
 
-          if (!CoveringMayIntersect(lhs_decoder, rhs_decoder, &intersection)) {
+          if (!CoveringMayIntersect(lhs_geog, rhs_geog, &intersection)) {
             return false;
           }
 
-          return filter(lhs_decoder.Decode(lhs_str), rhs_decoder.Decode(rhs_str));
+          return filter(lhs_arg, rhs_arg);
         });
   }
 
   static void ExecuteIntersectionFn(DataChunk& args, ExpressionState& state,
                                     Vector& result) {
-    ExecuteIntersection(args.data[0], args.data[1], result, args.size());
+    ExecuteIntersection(state, args.data[0], args.data[1], result, args.size());
   }
 
   static void ExecuteDifferenceFn(DataChunk& args, ExpressionState& state,
                                   Vector& result) {
-    ExecuteDifference(args.data[0], args.data[1], result, args.size());
+    ExecuteDifference(state, args.data[0], args.data[1], result, args.size());
   }
 
   static void ExecuteUnionFn(DataChunk& args, ExpressionState& state, Vector& result) {
-    ExecuteUnion(args.data[0], args.data[1], result, args.size());
+    ExecuteUnion(state, args.data[0], args.data[1], result, args.size());
   }
 
-  static void ExecuteIntersection(Vector& lhs, Vector& rhs, Vector& result, idx_t count) {
-    GeographyDecoder lhs_decoder;
-    GeographyDecoder rhs_decoder;
-    GeographyEncoder encoder;
-    std::vector<S2CellId> intersection;
-
-    s2geography::GlobalOptions options;
-    InitGlobalOptions(&options);
+  static void ExecuteIntersection(ExpressionState& state, Vector& lhs, Vector& rhs,
+                                  Vector& result, idx_t count) {
+    auto& local = BinaryOpLocalState::Get(state);
+    ArgState lhs_arg(state, local.lhs, lhs, 0);
+    ArgState rhs_arg(state, local.rhs, rhs, 1);
+    auto& encoder = local.encoder;
+    auto& intersection = local.intersection;
+    auto& options = local.global_options;
 
     BinaryExecutor::Execute<string_t, string_t, string_t>(
         lhs, rhs, result, count, [&](string_t lhs_str, string_t rhs_str) {
-          lhs_decoder.DecodeTagAndCovering(lhs_str);
+          auto& lhs_geog = lhs_arg.Init(lhs_str);
 
           // If the lefthand side is empty, the intersection is the righthand side
-          if (lhs_decoder.tag.flags & s2geography::EncodeTag::kFlagEmpty) {
+          if (lhs_geog.IsEmpty()) {
             return StringVector::AddStringOrBlob(result, rhs_str);
           }
 
           // If the righthand side is empty, the intersection is the lefthand side
-          rhs_decoder.DecodeTagAndCovering(rhs_str);
-          if (rhs_decoder.tag.flags & s2geography::EncodeTag::kFlagEmpty) {
+          auto& rhs_geog = rhs_arg.Init(rhs_str);
+          if (rhs_geog.IsEmpty()) {
             return StringVector::AddStringOrBlob(result, lhs_str);
           }
 
           // For definitely disjoint input, the intersection is empty
-          if (!CoveringMayIntersect(lhs_decoder, rhs_decoder, &intersection)) {
+          if (!CoveringMayIntersect(lhs_geog, rhs_geog, &intersection)) {
             auto geog = make_uniq<s2geography::GeographyCollection>();
-            return StringVector::AddStringOrBlob(result, encoder.Encode(*geog));
+            return encoder.Encode(*geog, result);
           }
 
-          auto geog = DispatchShapeIndexFilter(
-              lhs_decoder.Decode(lhs_str), rhs_decoder.Decode(rhs_str),
-              [&options](const S2ShapeIndex& lhs_index, const S2ShapeIndex& rhs_index) {
-                return s2geography::s2_boolean_operation(
-                    lhs_index, rhs_index, S2BooleanOperation::OpType::INTERSECTION,
-                    options);
-              });
+          auto geog = s2geography::s2_boolean_operation(
+              lhs_arg.ShapeIndex(), rhs_arg.ShapeIndex(),
+              S2BooleanOperation::OpType::INTERSECTION, options);
 
-          return StringVector::AddStringOrBlob(result, encoder.Encode(*geog));
+          return encoder.Encode(*geog, result);
         });
   }
 
-  static void ExecuteDifference(Vector& lhs, Vector& rhs, Vector& result, idx_t count) {
-    GeographyDecoder lhs_decoder;
-    GeographyDecoder rhs_decoder;
-    GeographyEncoder encoder;
-    std::vector<S2CellId> intersection;
-
-    s2geography::GlobalOptions options;
-    InitGlobalOptions(&options);
+  static void ExecuteDifference(ExpressionState& state, Vector& lhs, Vector& rhs,
+                                Vector& result, idx_t count) {
+    auto& local = BinaryOpLocalState::Get(state);
+    ArgState lhs_arg(state, local.lhs, lhs, 0);
+    ArgState rhs_arg(state, local.rhs, rhs, 1);
+    auto& encoder = local.encoder;
+    auto& intersection = local.intersection;
+    auto& options = local.global_options;
 
     BinaryExecutor::Execute<string_t, string_t, string_t>(
         lhs, rhs, result, count, [&](string_t lhs_str, string_t rhs_str) {
-          lhs_decoder.DecodeTagAndCovering(lhs_str);
+          auto& lhs_geog = lhs_arg.Init(lhs_str);
 
           // If the lefthand side is empty, the difference is also empty
-          if (lhs_decoder.tag.flags & s2geography::EncodeTag::kFlagEmpty) {
+          if (lhs_geog.IsEmpty()) {
             auto geog = make_uniq<s2geography::GeographyCollection>();
-            return StringVector::AddStringOrBlob(result, encoder.Encode(*geog));
+            return encoder.Encode(*geog, result);
           }
 
           // If the righthand side is empty, the difference is the lefthand side
-          rhs_decoder.DecodeTagAndCovering(rhs_str);
-          if (rhs_decoder.tag.flags & s2geography::EncodeTag::kFlagEmpty) {
+          auto& rhs_geog = rhs_arg.Init(rhs_str);
+          if (rhs_geog.IsEmpty()) {
             return StringVector::AddStringOrBlob(result, lhs_str);
           }
 
           // For definitely disjoint input, the intersection is the lefthand side
-          if (!CoveringMayIntersect(lhs_decoder, rhs_decoder, &intersection)) {
-            auto geog = make_uniq<s2geography::GeographyCollection>();
+          if (!CoveringMayIntersect(lhs_geog, rhs_geog, &intersection)) {
             return StringVector::AddStringOrBlob(result, lhs_str);
           }
 
-          auto geog = DispatchShapeIndexFilter(
-              lhs_decoder.Decode(lhs_str), rhs_decoder.Decode(rhs_str),
-              [&options](const S2ShapeIndex& lhs_index, const S2ShapeIndex& rhs_index) {
-                return s2geography::s2_boolean_operation(
-                    lhs_index, rhs_index, S2BooleanOperation::OpType::DIFFERENCE,
-                    options);
-              });
+          auto geog = s2geography::s2_boolean_operation(
+              lhs_arg.ShapeIndex(), rhs_arg.ShapeIndex(),
+              S2BooleanOperation::OpType::DIFFERENCE, options);
 
-          return StringVector::AddStringOrBlob(result, encoder.Encode(*geog));
+          return encoder.Encode(*geog, result);
         });
   }
 
-  static void ExecuteUnion(Vector& lhs, Vector& rhs, Vector& result, idx_t count) {
-    GeographyDecoder lhs_decoder;
-    GeographyDecoder rhs_decoder;
-    GeographyEncoder encoder;
-    std::vector<S2CellId> intersection;
-
-    s2geography::GlobalOptions options;
-    InitGlobalOptions(&options);
+  static void ExecuteUnion(ExpressionState& state, Vector& lhs, Vector& rhs,
+                           Vector& result, idx_t count) {
+    auto& local = BinaryOpLocalState::Get(state);
+    ArgState lhs_arg(state, local.lhs, lhs, 0);
+    ArgState rhs_arg(state, local.rhs, rhs, 1);
+    auto& encoder = local.encoder;
+    auto& options = local.global_options;
 
     BinaryExecutor::Execute<string_t, string_t, string_t>(
         lhs, rhs, result, count, [&](string_t lhs_str, string_t rhs_str) {
-          lhs_decoder.DecodeTagAndCovering(lhs_str);
+          auto& lhs_geog = lhs_arg.Init(lhs_str);
 
           // If the lefthand side is empty, the union is the righthand side
-          if (lhs_decoder.tag.flags & s2geography::EncodeTag::kFlagEmpty) {
+          if (lhs_geog.IsEmpty()) {
             return StringVector::AddStringOrBlob(result, rhs_str);
           }
 
           // If the righthand side is empty, the union is the lefthand side
-          rhs_decoder.DecodeTagAndCovering(rhs_str);
-          if (rhs_decoder.tag.flags & s2geography::EncodeTag::kFlagEmpty) {
+          auto& rhs_geog = rhs_arg.Init(rhs_str);
+          if (rhs_geog.IsEmpty()) {
             return StringVector::AddStringOrBlob(result, lhs_str);
           }
 
           // (No optimization for definitely disjoint binary union)
 
-          auto geog = DispatchShapeIndexFilter(
-              lhs_decoder.Decode(lhs_str), rhs_decoder.Decode(rhs_str),
-              [&options](const S2ShapeIndex& lhs_index, const S2ShapeIndex& rhs_index) {
-                return s2geography::s2_boolean_operation(
-                    lhs_index, rhs_index, S2BooleanOperation::OpType::UNION, options);
-              });
+          auto geog = s2geography::s2_boolean_operation(
+              lhs_arg.ShapeIndex(), rhs_arg.ShapeIndex(),
+              S2BooleanOperation::OpType::UNION, options);
 
-          return StringVector::AddStringOrBlob(result, encoder.Encode(*geog));
+          return encoder.Encode(*geog, result);
         });
   }
 
-  static bool CoveringMayIntersect(const GeographyDecoder& lhs,
-                                   const GeographyDecoder& rhs,
+  // The classes of geography kinds that have specialized predicate kernels
+  enum class KindClass { POINT, POLYLINE, POLYGON, OTHER };
+
+  static KindClass ClassOf(s2geography::GeographyKind kind) {
+    switch (kind) {
+      case s2geography::GeographyKind::POINT:
+      case s2geography::GeographyKind::CELL_CENTER:
+        return KindClass::POINT;
+      case s2geography::GeographyKind::POLYLINE:
+        return KindClass::POLYLINE;
+      case s2geography::GeographyKind::POLYGON:
+        return KindClass::POLYGON;
+      default:
+        return KindClass::OTHER;
+    }
+  }
+
+  struct IntersectsOp {
+    static constexpr bool kContains = false;
+
+    static bool Exact(const S2ShapeIndex& lhs, const S2ShapeIndex& rhs,
+                      const S2BooleanOperation::Options& options) {
+      return S2BooleanOperation::Intersects(lhs, rhs, options);
+    }
+  };
+
+  // Note: Polygon containment when there is a partial shared edge might
+  // need to be calculated differently.
+  struct ContainsOp {
+    static constexpr bool kContains = true;
+
+    static bool Exact(const S2ShapeIndex& lhs, const S2ShapeIndex& rhs,
+                      const S2BooleanOperation::Options& options) {
+      return S2BooleanOperation::Contains(lhs, rhs, options);
+    }
+  };
+
+  // Select the kernel for the (lhs, rhs) pair of kinds. Kinds are known from the
+  // tag (i.e., before anything is decoded).
+  template <typename Op>
+  static bool DispatchPredicate(ArgState& lhs, ArgState& rhs,
+                                const S2BooleanOperation::Options& options) {
+    switch (ClassOf(lhs.Current().Kind())) {
+      case KindClass::POINT:
+        return DispatchPredicateRhs<Op, KindClass::POINT>(lhs, rhs, options);
+      case KindClass::POLYLINE:
+        return DispatchPredicateRhs<Op, KindClass::POLYLINE>(lhs, rhs, options);
+      case KindClass::POLYGON:
+        return DispatchPredicateRhs<Op, KindClass::POLYGON>(lhs, rhs, options);
+      default:
+        return DispatchPredicateRhs<Op, KindClass::OTHER>(lhs, rhs, options);
+    }
+  }
+
+  template <typename Op, KindClass Lhs>
+  static bool DispatchPredicateRhs(ArgState& lhs, ArgState& rhs,
+                                const S2BooleanOperation::Options& options) {
+    switch (ClassOf(rhs.Current().Kind())) {
+      case KindClass::POINT:
+        return PredicateKernel<Op, Lhs, KindClass::POINT>::Execute(lhs, rhs, options);
+      case KindClass::POLYLINE:
+        return PredicateKernel<Op, Lhs, KindClass::POLYLINE>::Execute(lhs, rhs, options);
+      case KindClass::POLYGON:
+        return PredicateKernel<Op, Lhs, KindClass::POLYGON>::Execute(lhs, rhs, options);
+      default:
+        return PredicateKernel<Op, Lhs, KindClass::OTHER>::Execute(lhs, rhs, options);
+    }
+  }
+
+  // The general kernel: the boolean operation on the indexes of both sides,
+  // unless a polygon's interior covering proves the result
+  template <typename Op, KindClass Lhs, KindClass Rhs>
+  struct PredicateKernel {
+    static bool Execute(ArgState& lhs, ArgState& rhs,
+                        const S2BooleanOperation::Options& options) {
+      if constexpr (Lhs == KindClass::POLYGON) {
+        if (CoveringWithinInterior(rhs, lhs)) {
+          return true;
+        }
+      }
+
+      if constexpr (Rhs == KindClass::POLYGON && !Op::kContains) {
+        if (CoveringWithinInterior(lhs, rhs)) {
+          return true;
+        }
+      }
+
+      return Op::Exact(lhs.ShapeIndex(), rhs.ShapeIndex(), options);
+    }
+  };
+
+  // Points against points never need an index: two cell centers are compared by
+  // cell id and other points are compared directly
+  template <typename Op>
+  struct PredicateKernel<Op, KindClass::POINT, KindClass::POINT> {
+    static bool Execute(ArgState& lhs, ArgState& rhs,
+                        const S2BooleanOperation::Options& options) {
+      const PreparedGeography& lhs_geog = lhs.Current();
+      const PreparedGeography& rhs_geog = rhs.Current();
+      if (lhs_geog.Kind() == s2geography::GeographyKind::CELL_CENTER &&
+          rhs_geog.Kind() == s2geography::GeographyKind::CELL_CENTER) {
+        return lhs_geog.Covering()[0] == rhs_geog.Covering()[0];
+      }
+
+      const std::vector<S2Point>& lhs_points = lhs.Points();
+      return AnyOrAll(rhs.Points(), Op::kContains, [&](const S2Point& pt) {
+        return std::find(lhs_points.begin(), lhs_points.end(), pt) != lhs_points.end();
+      });
+    }
+  };
+
+  // Points on the rhs are tested against the lhs index with an
+  // S2ContainsPointQuery without building an index for the points. With the
+  // closed vertex model, a true result always matches the CLOSED polygon model
+  // used by the S2BooleanOperation. A point inside an edge (rather than on a
+  // vertex) is only detected by the S2BooleanOperation, so for polylines (or
+  // anything that might contain one) the query can only prove a true result and
+  // for polygons a false result is only trusted if no point is on an edge.
+  template <typename Op, KindClass Lhs>
+  struct PredicateKernel<Op, Lhs, KindClass::POINT> {
+    static bool Execute(ArgState& lhs, ArgState& rhs,
+                        const S2BooleanOperation::Options& options) {
+      if constexpr (Lhs == KindClass::POLYGON) {
+        if (CoveringWithinInterior(rhs, lhs)) {
+          return true;
+        }
+      }
+
+      const S2ShapeIndex& index = lhs.ShapeIndex();
+      const std::vector<S2Point>& points = rhs.Points();
+      if (ContainsPoints(index, points, Op::kContains)) {
+        return true;
+      }
+
+      if (Lhs != KindClass::POLYGON && (Lhs != KindClass::OTHER || HasPolylines(index))) {
+        return Op::Exact(index, rhs.ShapeIndex(), options);
+      }
+
+      if (AnyPointOnEdgeLine(index, points)) {
+        return Op::Exact(index, rhs.ShapeIndex(), options);
+      }
+
+      return false;
+    }
+  };
+
+  // Points on the lhs can only contain other points (or an empty polygon, which
+  // never gets here); intersection is symmetric
+  template <typename Op, KindClass Rhs>
+  struct PredicateKernel<Op, KindClass::POINT, Rhs> {
+    static bool Execute(ArgState& lhs, ArgState& rhs,
+                        const S2BooleanOperation::Options& options) {
+      if constexpr (!Op::kContains) {
+        return PredicateKernel<Op, Rhs, KindClass::POINT>::Execute(rhs, lhs, options);
+      } else if constexpr (Rhs == KindClass::POLYGON) {
+        return false;
+      } else {
+        return Op::Exact(lhs.ShapeIndex(), rhs.ShapeIndex(), options);
+      }
+    }
+  };
+
+  static bool ContainsPoints(const S2ShapeIndex& index,
+                             const std::vector<S2Point>& points, bool all) {
+    auto query = MakeS2ContainsPointQuery(
+        &index, S2ContainsPointQueryOptions(S2VertexModel::CLOSED));
+    return AnyOrAll(points, all, [&](const S2Point& pt) { return query.Contains(pt); });
+  }
+
+  // True if any point is exactly on the great circle through an edge of the
+  // index cell containing it (i.e., it might be inside that edge). This is
+  // rare and only requires checking the few edges of one cell.
+  static bool AnyPointOnEdgeLine(const S2ShapeIndex& index,
+                                 const std::vector<S2Point>& points) {
+    S2ShapeIndex::Iterator it(&index, S2ShapeIndex::UNPOSITIONED);
+    for (const S2Point& pt : points) {
+      if (!it.Locate(pt)) {
+        continue;
+      }
+
+      const S2ShapeIndexCell& cell = it.cell();
+      for (int i = 0; i < cell.num_clipped(); i++) {
+        const S2ClippedShape& clipped = cell.clipped(i);
+        const S2Shape* shape = index.shape(clipped.shape_id());
+        for (int j = 0; j < clipped.num_edges(); j++) {
+          S2Shape::Edge edge = shape->edge(clipped.edge(j));
+          if (s2pred::ExpensiveSign(edge.v0, edge.v1, pt, /*perturb=*/false) == 0) {
+            return true;
+          }
+        }
+      }
+    }
+
+    return false;
+  }
+
+  static bool HasPolylines(const S2ShapeIndex& index) {
+    for (int i = 0; i < index.num_shape_ids(); i++) {
+      const S2Shape* shape = index.shape(i);
+      if (shape != nullptr && shape->dimension() == 1) {
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  // True if every cell of the covering of inner is inside a cell of the interior
+  // covering of outer (a polygon), which proves that outer contains (and
+  // intersects) inner without an exact test
+  static bool CoveringWithinInterior(ArgState& inner, ArgState& outer) {
+    const std::vector<S2CellId>& covering = inner.Current().Covering();
+    if (covering.empty()) {
+      return false;
+    }
+
+    const std::vector<S2CellId>& interior = outer.InteriorCovering();
+    if (interior.empty()) {
+      return false;
+    }
+
+    // Same as S2CellUnion::Contains(S2CellId) for a normalized union
+    return std::all_of(covering.begin(), covering.end(), [&](S2CellId cell) {
+      auto it = std::lower_bound(interior.begin(), interior.end(), cell);
+      if (it != interior.end() && it->range_min() <= cell) {
+        return true;
+      }
+
+      return it != interior.begin() && (--it)->range_max() >= cell;
+    });
+  }
+
+  template <typename Predicate>
+  static bool AnyOrAll(const std::vector<S2Point>& points, bool all,
+                       Predicate&& predicate) {
+    if (all) {
+      return std::all_of(points.begin(), points.end(), predicate);
+    } else {
+      return std::any_of(points.begin(), points.end(), predicate);
+    }
+  }
+
+  static bool CoveringMayIntersect(const PreparedGeography& lhs,
+                                   const PreparedGeography& rhs,
                                    std::vector<S2CellId>* intersection_scratch) {
     // We don't currently omit coverings but in case we do by accident,
     // an omitted covering *might* intersect since it was just not generated.
-    if (lhs.covering.empty() || rhs.covering.empty()) {
+    if (lhs.Covering().empty() || rhs.Covering().empty()) {
       return true;
     }
 
-    S2CellUnion::GetIntersection(lhs.covering, rhs.covering, intersection_scratch);
+    S2CellUnion::GetIntersection(lhs.Covering(), rhs.Covering(), intersection_scratch);
     return !intersection_scratch->empty();
   }
 };
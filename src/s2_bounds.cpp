@@ -9,7 +9,9 @@
 #include "s2geography/accessors.h"
 
 #include "s2/s2cell_union.h"
+#include "s2_executor.hpp"
 #include "s2_geography_serde.hpp"
+#include "s2_settings.hpp"
 #include "s2_types.hpp"
 
 #include "function_builder.hpp"
@@ -21,12 +23,24 @@ namespace duckdb_s2 {
 namespace {
 
 struct S2Covering {
+  // The decoder and coverers are reused for every chunk
+  struct LocalState {
+    explicit LocalState(ClientContext& context) {
+      InitCovererOptions(context, coverer.mutable_options());
+    }
+
+    GeographyDecoder decoder;
+    S2RegionCoverer coverer;
+    S2RegionCoverer fixed_level_coverer;
+  };
+
   static void Register(DatabaseInstance& instance) {
     FunctionBuilder::RegisterScalar(
         instance, "s2_covering", [](ScalarFunctionBuilder& func) {
           func.AddVariant([](ScalarFunctionVariantBuilder& variant) {
             variant.AddParameter("geog", Types::GEOGRAPHY());
             variant.SetReturnType(Types::S2_CELL_UNION());
+            variant.SetLocalState<LocalState>();
             variant.SetFunction(ExecuteFn);
           });
 
@@ -41,6 +55,9 @@ Note that an S2_CELL_UNION is a thin wrapper around a LIST of S2_CELL, such
 that DuckDB LIST functions can be used to unnest, extract, or otherwise
 interact with the result.
 
+The maximum number and level of cells in the covering can be set with the
+`s2_covering_max_cells` and `s2_covering_max_level` settings.
+
 See the [Cell Operators](#cellops) section for ways to interact with cells.
 )");
           func.SetExample(R"(
@@ -64,6 +81,7 @@ s2_cell_contains(cell, s2_data_city('Berlin')::S2_CELL_CENTER::S2_CELL);
             variant.AddParameter("geog", Types::GEOGRAPHY());
             variant.AddParameter("fixed_level", LogicalType::INTEGER);
             variant.SetReturnType(Types::S2_CELL_UNION());
+            variant.SetLocalState<LocalState>();
             variant.SetFunction(ExecuteFnFixedLevel);
           });
 
@@ -85,8 +103,8 @@ SELECT s2_covering_fixed_level(s2_data_country('Germany'), 4) AS covering;
   }
 
   static inline void ExecuteFn(DataChunk& args, ExpressionState& state, Vector& result) {
-    S2RegionCoverer coverer;
-    Execute(args.data[0], result, args.size(), coverer);
+    auto& local = ScalarFunctionLocalState<LocalState>::Get(state);
+    Execute(args.data[0], result, args.size(), local.decoder, local.coverer);
   }
 
   static inline void ExecuteFnFixedLevel(DataChunk& args, ExpressionState& state,
@@ -102,19 +120,17 @@ SELECT s2_covering_fixed_level(s2_data_country('Germany'), 4) AS covering;
           "s2_covering_fixed_level(): level must be between 0 and 30");
     }
 
-    S2RegionCoverer coverer;
-    coverer.mutable_options()->set_fixed_level(fixed_level);
-    Execute(args.data[0], result, args.size(), coverer);
+    auto& local = ScalarFunctionLocalState<LocalState>::Get(state);
+    local.fixed_level_coverer.mutable_options()->set_fixed_level(fixed_level);
+    Execute(args.data[0], result, args.size(), local.decoder, local.fixed_level_coverer);
   }
 
   static void Execute(Vector& source, Vector& result, idx_t count,
-                      S2RegionCoverer& coverer) {
+                      GeographyDecoder& decoder, S2RegionCoverer& coverer) {
     ListVector::Reserve(result, count * coverer.options().max_cells());
     uint64_t offset = 0;
 
-    GeographyDecoder decoder;
-
-    UnaryExecutor::Execute<string_t, list_entry_t>(
+    GeographyExecutor::ExecuteUnary<string_t, list_entry_t>(
         source, result, count, [&](string_t geog_str) {
           decoder.DecodeTag(geog_str);
           if (decoder.tag.flags & s2geography::EncodeTag::kFlagEmpty) {
@@ -133,8 +149,8 @@ SELECT s2_covering_fixed_level(s2_data_country('Germany'), 4) AS covering;
             }
 
             default: {
-              auto geog = decoder.Decode(geog_str);
-              S2CellUnion covering = coverer.GetCovering(*geog->Region());
+              auto& geog = decoder.DecodeInPlace(geog_str);
+              S2CellUnion covering = coverer.GetCovering(*geog.Region());
               for (const auto cell_id : covering) {
                 ListVector::PushBack(result, Value::UBIGINT(cell_id.id()));
               }
@@ -155,6 +171,7 @@ struct S2BoundsRect {
           func.AddVariant([](ScalarFunctionVariantBuilder& variant) {
             variant.AddParameter("geog", Types::GEOGRAPHY());
             variant.SetReturnType(Types::S2_BOX());
+            variant.SetLocalState<GeographyDecoder>();
             variant.SetFunction(ExecuteFn);
           });
 
@@ -183,9 +200,9 @@ SELECT s2_bounds_box(s2_data_country('Fiji')) as rect;
     using BOX_TYPE = StructTypeQuaternary<double, double, double, double>;
     using GEOGRAPHY_TYPE = PrimitiveType<string_t>;
 
-    GeographyDecoder decoder;
+    auto& decoder = ScalarFunctionLocalState<GeographyDecoder>::Get(state);
 
-    GenericExecutor::ExecuteUnary<GEOGRAPHY_TYPE, BOX_TYPE>(
+    GeographyExecutor::ExecuteUnaryGeneric<GEOGRAPHY_TYPE, BOX_TYPE>(
         input, result, count, [&](GEOGRAPHY_TYPE& blob) {
           decoder.DecodeTag(blob.val);
           S2LatLngRect out;
@@ -195,9 +212,11 @@ SELECT s2_bounds_box(s2_data_country('Fiji')) as rect;
             uint64_t cell_id = LittleEndian::Load64(blob.val.GetData() + 4);
             S2CellId cell(cell_id);
             out = S2LatLngRect::FromPoint(cell.ToLatLng());
+          } else if (decoder.HasBounds()) {
+            decoder.DecodeTagAndBounds(blob.val);
+            out = decoder.bounds;
           } else {
-            auto geog = decoder.Decode(blob.val);
-            out = geog->Region()->GetRectBound();
+            out = decoder.DecodeInPlace(blob.val).Region()->GetRectBound();
           }
           return BOX_TYPE{out.lng_lo().degrees(), out.lat_lo().degrees(),
                           out.lng_hi().degrees(), out.lat_hi().degrees()};
@@ -238,7 +257,8 @@ struct S2BoundsRectAgg {
 
   template <class INPUT_TYPE, class STATE, class OP>
   static void Operation(STATE& state, const INPUT_TYPE& input, AggregateUnaryInput&) {
-    GeographyDecoder decoder;
+    // Aggregates don't have function-local state, so reuse one decoder per thread
+    static thread_local GeographyDecoder decoder;
     decoder.DecodeTag(input);
     if (decoder.tag.flags & s2geography::EncodeTag::kFlagEmpty) {
       return;
@@ -250,6 +270,9 @@ struct S2BoundsRectAgg {
       S2LatLng pt = cell.ToLatLng();
       S2LatLngRect rect(pt, pt);
       state.Union(rect);
+    } else if (decoder.HasBounds()) {
+      decoder.DecodeTagAndBounds(input);
+      state.Union(decoder.bounds);
     } else {
       auto geog = decoder.Decode(input);
       S2LatLngRect rect = geog->Region()->GetRectBound();
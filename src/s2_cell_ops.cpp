@@ -1,13 +1,19 @@
 
+#include <limits>
+
 #include "duckdb/main/database.hpp"
 #include "duckdb/main/extension_util.hpp"
 
 #include "s2/s2cell.h"
 #include "s2/s2cell_union.h"
+#include "s2geography/accessors.h"
 #include "s2geography/op/cell.h"
 #include "s2geography/op/point.h"
 
+#include "s2_cell_ops.hpp"
+#include "s2_executor.hpp"
 #include "s2_geography_serde.hpp"
+#include "s2_settings.hpp"
 #include "s2_types.hpp"
 
 #include "function_builder.hpp"
@@ -18,6 +24,18 @@ namespace duckdb_s2 {
 
 namespace {
 
+// Local state for casts that produce geographies, which are encoded using the
+// current settings (or the defaults if the cast has no client context)
+struct GeographyCastLocalState {
+  explicit GeographyCastLocalState(optional_ptr<ClientContext> context) {
+    if (context) {
+      InitGeographyEncoder(*context, &encoder);
+    }
+  }
+
+  GeographyEncoder encoder;
+};
+
 struct S2CellCenterFromGeography {
   static inline bool ExecuteCast(Vector& source, Vector& result, idx_t count,
                                  CastParameters& parameters) {
@@ -28,7 +46,7 @@ struct S2CellCenterFromGeography {
   static inline void Execute(Vector& source, Vector& result, idx_t count) {
     GeographyDecoder decoder;
 
-    UnaryExecutor::Execute<string_t, int64_t>(
+    GeographyExecutor::ExecuteUnary<string_t, int64_t>(
         source, result, count, [&](string_t geog_str) {
           decoder.DecodeTag(geog_str);
 
@@ -46,16 +64,16 @@ struct S2CellCenterFromGeography {
           }
 
           // Otherwise, we just need to load the geography
-          std::unique_ptr<s2geography::Geography> geog = decoder.Decode(geog_str);
+          auto& geog = decoder.DecodeInPlace(geog_str);
 
           // Use the Shape interface, which should work for PointGeography
           // and EncodedShapeIndex geography. A single shape with a single
           // edge always works here.
-          if (geog->num_shapes() != 1) {
+          if (geog.num_shapes() != 1) {
             return static_cast<int64_t>(S2CellId::Sentinel().id());
           }
 
-          std::unique_ptr<S2Shape> shape = geog->Shape(0);
+          std::unique_ptr<S2Shape> shape = geog.Shape(0);
           if (shape->num_edges() != 1 || shape->dimension() != 0) {
             throw InvalidInputException(
                 std::string("Can't convert geography that is not empty nor a single "
@@ -68,6 +86,87 @@ struct S2CellCenterFromGeography {
   }
 };
 
+struct S2SortKey {
+  static void Register(DatabaseInstance& instance) {
+    FunctionBuilder::RegisterScalar(
+        instance, "s2_sortkey", [](ScalarFunctionBuilder& func) {
+          func.AddVariant([](ScalarFunctionVariantBuilder& variant) {
+            variant.AddParameter("geog", Types::GEOGRAPHY());
+            variant.SetReturnType(Types::S2_CELL());
+            variant.SetLocalState<GeographyDecoder>();
+            variant.SetFunction(ExecuteFn);
+          });
+
+          func.SetDescription(R"(
+Get an S2_CELL that can be used to sort geographies such that nearby
+geographies are close together.
+
+For a point, this is the cell of the point; for anything else it is the
+smallest cell that contains the covering stored with the geography (which
+does not require decoding it). Empty geographies sort last. Writing a table
+ordered by this key makes its row groups spatially compact such that filters
+on cell and bounding box columns can skip more data.
+)");
+          func.SetExample(R"(
+SELECT name, s2_sortkey(geog) AS key
+FROM s2_data_countries()
+ORDER BY key
+LIMIT 5;
+----
+-- Write spatially compact row groups
+COPY (
+  SELECT name, s2_sortkey(geog) AS cell, s2_aswkb(geog) AS geometry
+  FROM s2_data_countries()
+  ORDER BY cell
+) TO 'countries.parquet' (FORMAT PARQUET);
+)");
+
+          func.SetTag("ext", "geography");
+          func.SetTag("category", "cellops");
+        });
+  }
+
+  static inline void ExecuteFn(DataChunk& args, ExpressionState& state, Vector& result) {
+    auto& decoder = ScalarFunctionLocalState<GeographyDecoder>::Get(state);
+    Execute(args.data[0], result, args.size(), decoder);
+  }
+
+  static inline void Execute(Vector& source, Vector& result, idx_t count,
+                             GeographyDecoder& decoder) {
+    GeographyExecutor::ExecuteUnary<string_t, int64_t>(
+        source, result, count, [&](string_t geog_str) {
+          decoder.DecodeTag(geog_str);
+          if (decoder.tag.flags & s2geography::EncodeTag::kFlagEmpty) {
+            return static_cast<int64_t>(S2CellId::Sentinel().id());
+          }
+
+          if (decoder.tag.kind == s2geography::GeographyKind::CELL_CENTER &&
+              decoder.tag.covering_size == 1) {
+            uint64_t cell_id = LittleEndian::Load64(geog_str.GetData() + 4);
+            return static_cast<int64_t>(cell_id);
+          }
+
+          // The covering is sorted, so the common ancestor of the first and last
+          // cells contains all of them (or they are on different faces)
+          if (decoder.tag.covering_size > 0) {
+            decoder.DecodeTagAndCovering(geog_str);
+            const S2CellId& first = decoder.covering.front();
+            int level = first.GetCommonAncestorLevel(decoder.covering.back());
+            return static_cast<int64_t>(first.parent(MaxValue(level, 0)).id());
+          }
+
+          // Otherwise (e.g., points that weren't stored as cell centers) we need
+          // to decode
+          S2Point centroid = s2geography::s2_centroid(decoder.DecodeInPlace(geog_str));
+          if (centroid.Norm2() == 0) {
+            return static_cast<int64_t>(S2CellId::Sentinel().id());
+          }
+
+          return static_cast<int64_t>(S2CellId(centroid.Normalize()).id());
+        });
+  }
+};
+
 struct S2CellUnionFromS2Cell {
   static inline bool ExecuteCast(Vector& source, Vector& result, idx_t count,
                                  CastParameters& parameters) {
@@ -135,12 +234,13 @@ struct S2CellUnionFromStorage {
 struct S2CellUnionToGeography {
   static inline bool ExecuteCast(Vector& source, Vector& result, idx_t count,
                                  CastParameters& parameters) {
-    Execute(source, result, count);
+    auto& local = CastFunctionLocalState<GeographyCastLocalState>::Get(parameters);
+    Execute(source, result, count, local.encoder);
     return true;
   }
 
-  static inline void Execute(Vector& source, Vector& result, idx_t count) {
-    GeographyEncoder encoder;
+  static inline void Execute(Vector& source, Vector& result, idx_t count,
+                             GeographyEncoder& encoder) {
     vector<S2CellId> cell_ids;
     // Not sure if this is the appropriate way to handle list child data
     // in the presence of a possible dictionary vector as a source
@@ -164,7 +264,7 @@ struct S2CellUnionToGeography {
 
           // Would be nice if we could set the covering here since we already
           // know exactly what it is!
-          return StringVector::AddStringOrBlob(result, encoder.Encode(geog));
+          return encoder.Encode(geog, result);
         });
   }
 };
@@ -499,16 +599,59 @@ LIMIT 5;
 
   static inline void Execute(Vector& src_lon, Vector& src_lat, Vector& result,
                              idx_t count) {
-    BinaryExecutor::Execute<double, double, int64_t>(
-        src_lon, src_lat, result, count, [&](double lon, double lat) {
-          if (std::isnan(lon) && std::isnan(lat)) {
-            return static_cast<int64_t>(S2CellId::Sentinel().id());
-          }
+    if (src_lon.GetVectorType() == VectorType::CONSTANT_VECTOR &&
+        src_lat.GetVectorType() == VectorType::CONSTANT_VECTOR) {
+      result.SetVectorType(VectorType::CONSTANT_VECTOR);
+      if (ConstantVector::IsNull(src_lon) || ConstantVector::IsNull(src_lat)) {
+        ConstantVector::SetNull(result, true);
+      } else {
+        LngLatToCellIds(ConstantVector::GetData<double>(src_lon),
+                        ConstantVector::GetData<double>(src_lat), 1,
+                        ResultData(result));
+      }
+      return;
+    }
 
-          auto latlng = S2LatLng::FromDegrees(lat, lon);
-          S2CellId cell_id(latlng.ToPoint());
-          return static_cast<int64_t>(cell_id.id());
-        });
+    UnifiedVectorFormat lon_format;
+    UnifiedVectorFormat lat_format;
+    src_lon.ToUnifiedFormat(count, lon_format);
+    src_lat.ToUnifiedFormat(count, lat_format);
+    auto lon_data = UnifiedVectorFormat::GetData<double>(lon_format);
+    auto lat_data = UnifiedVectorFormat::GetData<double>(lat_format);
+
+    result.SetVectorType(VectorType::FLAT_VECTOR);
+    auto& result_validity = FlatVector::Validity(result);
+
+    // The kernel needs contiguous coordinates: flat input can be used as is but
+    // anything else (e.g., one constant argument or a dictionary) is gathered first
+    double lon_buffer[STANDARD_VECTOR_SIZE];
+    double lat_buffer[STANDARD_VECTOR_SIZE];
+    if (src_lon.GetVectorType() != VectorType::FLAT_VECTOR ||
+        src_lat.GetVectorType() != VectorType::FLAT_VECTOR) {
+      for (idx_t i = 0; i < count; i++) {
+        lon_buffer[i] = lon_data[lon_format.sel->get_index(i)];
+        lat_buffer[i] = lat_data[lat_format.sel->get_index(i)];
+      }
+
+      lon_data = lon_buffer;
+      lat_data = lat_buffer;
+    }
+
+    LngLatToCellIds(lon_data, lat_data, count, ResultData(result));
+
+    if (!lon_format.validity.AllValid() || !lat_format.validity.AllValid()) {
+      for (idx_t i = 0; i < count; i++) {
+        if (!lon_format.validity.RowIsValid(lon_format.sel->get_index(i)) ||
+            !lat_format.validity.RowIsValid(lat_format.sel->get_index(i))) {
+          result_validity.SetInvalid(i);
+        }
+      }
+    }
+  }
+
+  // S2_CELL_CENTER is stored as a BIGINT but the kernel writes unsigned ids
+  static uint64_t* ResultData(Vector& result) {
+    return reinterpret_cast<uint64_t*>(result.GetData());
   }
 };
 
@@ -520,58 +663,121 @@ struct S2CellCenterToGeography {
   }
 
   static inline void Execute(Vector& source, Vector& result, idx_t count) {
-    // Most cells will get serialized as a tag + cell_id
-    Encoder non_empty;
-    s2geography::EncodeTag tag;
-    tag.kind = s2geography::GeographyKind::CELL_CENTER;
-    tag.covering_size = 1;
-    tag.Encode(&non_empty);
-    non_empty.Ensure(sizeof(uint64_t));
-    non_empty.put64(0);
-    string_t non_empty_str{non_empty.base(), static_cast<uint32_t>(non_empty.length())};
-    char* non_empty_cell_id = non_empty_str.GetPrefixWriteable() + 4;
-
-    // Invalid cells will get serialized as an empty point
-    Encoder empty;
-    tag.kind = s2geography::GeographyKind::POINT;
-    tag.covering_size = 0;
-    tag.flags |= s2geography::EncodeTag::kFlagEmpty;
-    tag.Encode(&empty);
-    string_t empty_str{empty.base(), static_cast<uint32_t>(empty.length())};
-
+    CellCenterEncoder encoder;
     UnaryExecutor::Execute<int64_t, string_t>(source, result, count, [&](int64_t arg0) {
-      S2CellId cell(arg0);
-      if (cell.is_valid()) {
-        std::memcpy(non_empty_cell_id, &arg0, sizeof(arg0));
-        return non_empty_str;
+      return encoder.Encode(static_cast<uint64_t>(arg0));
+    });
+  }
+};
+
+// geoarrow.point with separated coordinates is a STRUCT(x DOUBLE, y DOUBLE),
+// which is how these arrays are read from Arrow or GeoParquet. These are
+// converted a vector at a time without creating a geography for each row. Like
+// points parsed from WKT or WKB, a point is only stored as a cell center if that
+// is exact (snapping to the cell center is an explicit cast to S2_CELL_CENTER,
+// which converts the whole vector to cell ids at once).
+struct S2GeographyFromGeoArrowPoint {
+  static LogicalType PointType() {
+    return LogicalType::STRUCT({{"x", LogicalType::DOUBLE}, {"y", LogicalType::DOUBLE}});
+  }
+
+  static inline bool ExecuteCast(Vector& source, Vector& result, idx_t count,
+                                 CastParameters& parameters) {
+    auto& local = CastFunctionLocalState<GeographyCastLocalState>::Get(parameters);
+    Execute(source, result, count, local.encoder);
+    return true;
+  }
+
+  static inline bool ExecuteCellCenterCast(Vector& source, Vector& result, idx_t count,
+                                           CastParameters& parameters) {
+    ExecuteCellCenter(source, result, count);
+    return true;
+  }
+
+  static inline void Execute(Vector& source, Vector& result, idx_t count,
+                             GeographyEncoder& encoder) {
+    ParsedPointEncoder point_encoder;
+    const double empty[2] = {std::numeric_limits<double>::quiet_NaN(),
+                             std::numeric_limits<double>::quiet_NaN()};
+    ExecutePoints<string_t>(
+        source, result, count, [](const double* x, const double* y) {},
+        [&](idx_t i, const double* lnglat) {
+          return point_encoder.Encode(lnglat ? lnglat : empty, encoder, result);
+        });
+  }
+
+  static inline void ExecuteCellCenter(Vector& source, Vector& result, idx_t count) {
+    uint64_t cell_ids[STANDARD_VECTOR_SIZE];
+    ExecutePoints<int64_t>(
+        source, result, count,
+        [&](const double* x, const double* y) { LngLatToCellIds(x, y, count, cell_ids); },
+        [&](idx_t i, const double* lnglat) {
+          return static_cast<int64_t>(lnglat ? cell_ids[i] : S2CellId::Sentinel().id());
+        });
+  }
+
+  // Calls prepare() with all x and y values of source at once and then writes
+  // convert() for each point to result. Null points are null in the output;
+  // points with a null coordinate are converted with a null lnglat (i.e., as
+  // empty).
+  template <typename RESULT_TYPE, typename Prepare, typename Convert>
+  static void ExecutePoints(Vector& source, Vector& result, idx_t count,
+                            Prepare&& prepare, Convert&& convert) {
+    Vector points(source.GetType());
+    points.Reference(source);
+    points.Flatten(count);
+
+    auto& children = StructVector::GetEntries(points);
+    auto x = FlatVector::GetData<double>(*children[0]);
+    auto y = FlatVector::GetData<double>(*children[1]);
+    auto& x_validity = FlatVector::Validity(*children[0]);
+    auto& y_validity = FlatVector::Validity(*children[1]);
+    auto& validity = FlatVector::Validity(points);
+
+    prepare(x, y);
+
+    result.SetVectorType(VectorType::FLAT_VECTOR);
+    auto result_data = FlatVector::GetData<RESULT_TYPE>(result);
+    auto& result_validity = FlatVector::Validity(result);
+    for (idx_t i = 0; i < count; i++) {
+      if (!validity.RowIsValid(i)) {
+        result_validity.SetInvalid(i);
+      } else if (!x_validity.RowIsValid(i) || !y_validity.RowIsValid(i)) {
+        result_data[i] = convert(i, nullptr);
       } else {
-        return empty_str;
+        const double lnglat[2] = {x[i], y[i]};
+        result_data[i] = convert(i, lnglat);
       }
-    });
+    }
+
+    if (source.GetVectorType() == VectorType::CONSTANT_VECTOR) {
+      result.SetVectorType(VectorType::CONSTANT_VECTOR);
+    }
   }
 };
 
 struct S2CellToGeography {
   static inline bool ExecuteCast(Vector& source, Vector& result, idx_t count,
                                  CastParameters& parameters) {
-    Execute(source, result, count);
+    auto& local = CastFunctionLocalState<GeographyCastLocalState>::Get(parameters);
+    Execute(source, result, count, local.encoder);
     return true;
   }
 
-  static inline void Execute(Vector& source, Vector& result, idx_t count) {
-    GeographyEncoder encoder;
+  static inline void Execute(Vector& source, Vector& result, idx_t count,
+                             GeographyEncoder& encoder) {
 
     UnaryExecutor::Execute<int64_t, string_t>(source, result, count, [&](int64_t arg0) {
       S2CellId cell(arg0);
       if (!cell.is_valid()) {
         s2geography::PolygonGeography geog;
-        return StringVector::AddStringOrBlob(result, encoder.Encode(geog));
+        return encoder.Encode(geog, result);
       }
 
       auto loop = make_uniq<S2Loop>(S2Cell(cell));
       auto poly = make_uniq<S2Polygon>(std::move(loop));
       s2geography::PolygonGeography geog(std::move(poly));
-      return StringVector::AddStringOrBlob(result, encoder.Encode(geog));
+      return encoder.Encode(geog, result);
     });
   }
 };
@@ -622,7 +828,7 @@ SELECT '5/'::S2_CELL::GEOGRAPHY as geog;
         [&](int64_t cell_id, int32_t vertex_id) {
           Point pt = op.ExecuteScalar(cell_id, static_cast<int8_t>(vertex_id));
           s2geography::PointGeography geog({pt[0], pt[1], pt[2]});
-          return StringVector::AddStringOrBlob(result, encoder.Encode(geog));
+          return encoder.Encode(geog, result);
         });
   }
 };
@@ -1011,6 +1217,45 @@ bool ExecuteNoopCast(Vector& source, Vector& result, idx_t count,
 
 }  // namespace
 
+bool TryLngLatFromPointWKB(string_t wkb, double* lnglat) {
+  Decoder decoder(wkb.GetData(), wkb.GetSize());
+  if (decoder.avail() < (sizeof(uint8_t) + sizeof(uint32_t))) {
+    return false;
+  }
+
+  uint8_t le = decoder.get8();
+  uint32_t geometry_type;
+  if (le) {
+    geometry_type = LittleEndian::Load32(decoder.skip(sizeof(uint32_t)));
+  } else {
+    geometry_type = BigEndian::Load32(decoder.skip(sizeof(uint32_t)));
+  }
+
+  if (geometry_type & S2CellCenterFromWKB::ewkb_srid_bit) {
+    if (decoder.avail() < sizeof(uint32_t)) {
+      return false;
+    }
+
+    decoder.skip(sizeof(uint32_t));
+  }
+
+  geometry_type &=
+      ~(S2CellCenterFromWKB::ewkb_srid_bit | S2CellCenterFromWKB::ewkb_zm_bits);
+  if ((geometry_type % 1000) != 1 || decoder.avail() < (2 * sizeof(double))) {
+    return false;
+  }
+
+  if (le) {
+    lnglat[0] = LittleEndian::Load<double>(decoder.skip(sizeof(double)));
+    lnglat[1] = LittleEndian::Load<double>(decoder.skip(sizeof(double)));
+  } else {
+    lnglat[0] = BigEndian::Load<double>(decoder.skip(sizeof(double)));
+    lnglat[1] = BigEndian::Load<double>(decoder.skip(sizeof(double)));
+  }
+
+  return true;
+}
+
 void RegisterS2CellOps(DatabaseInstance& instance) {
   using namespace s2geography::op::cell;
 
@@ -1040,14 +1285,30 @@ void RegisterS2CellOps(DatabaseInstance& instance) {
       instance, Types::GEOGRAPHY(), Types::S2_CELL_CENTER(),
       BoundCastInfo(S2CellCenterFromGeography::ExecuteCast), 1);
 
+  // geoarrow.point (as read from Arrow or GeoParquet) to geography or
+  // s2_cell_center is explicit
+  ExtensionUtil::RegisterCastFunction(
+      instance, S2GeographyFromGeoArrowPoint::PointType(), Types::GEOGRAPHY(),
+      BoundCastInfo(S2GeographyFromGeoArrowPoint::ExecuteCast, nullptr,
+                    CastFunctionLocalState<GeographyCastLocalState>::Init),
+      1);
+  ExtensionUtil::RegisterCastFunction(
+      instance, S2GeographyFromGeoArrowPoint::PointType(), Types::S2_CELL_CENTER(),
+      BoundCastInfo(S2GeographyFromGeoArrowPoint::ExecuteCellCenterCast), 1);
+
   // s2_cell to geography can be implicit (never fails for valid input)
-  ExtensionUtil::RegisterCastFunction(instance, Types::S2_CELL(), Types::GEOGRAPHY(),
-                                      BoundCastInfo(S2CellToGeography::ExecuteCast), 0);
+  ExtensionUtil::RegisterCastFunction(
+      instance, Types::S2_CELL(), Types::GEOGRAPHY(),
+      BoundCastInfo(S2CellToGeography::ExecuteCast, nullptr,
+                    CastFunctionLocalState<GeographyCastLocalState>::Init),
+      0);
 
   // s2_cell_union to geography can be implicit
   ExtensionUtil::RegisterCastFunction(
       instance, Types::S2_CELL_UNION(), Types::GEOGRAPHY(),
-      BoundCastInfo(S2CellUnionToGeography::ExecuteCast), 0);
+      BoundCastInfo(S2CellUnionToGeography::ExecuteCast, nullptr,
+                    CastFunctionLocalState<GeographyCastLocalState>::Init),
+      0);
 
   // s2_cell to s2_cell_union can be implicit
   ExtensionUtil::RegisterCastFunction(instance, Types::S2_CELL(), Types::S2_CELL_UNION(),
@@ -1088,6 +1349,8 @@ void RegisterS2CellOps(DatabaseInstance& instance) {
   S2CellEdgeNeighbor::Register(instance);
 
   S2CellBounds::Register(instance);
+
+  S2SortKey::Register(instance);
 }
 
 }  // namespace duckdb_s2
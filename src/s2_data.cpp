@@ -8,6 +8,7 @@
 
 #include "s2_data_static.hpp"
 #include "s2_geography_serde.hpp"
+#include "s2_settings.hpp"
 #include "s2_types.hpp"
 
 #include "function_builder.hpp"
@@ -53,6 +54,7 @@ void S2DataCitiesScan(ClientContext& context, TableFunctionInput& data_p,
 
   s2geography::WKTReader reader;
   GeographyEncoder encoder;
+  InitGeographyEncoder(context, &encoder);
   Vector& names = output.data[0];
   Vector& populations = output.data[1];
   Vector& geogs = output.data[2];
@@ -68,7 +70,7 @@ void S2DataCitiesScan(ClientContext& context, TableFunctionInput& data_p,
     populations.SetValue(i - start, city.population);
 
     auto geog = reader.read_feature(city.geog_wkt);
-    string_t encoded = StringVector::AddStringOrBlob(geogs, encoder.Encode(*geog));
+    string_t encoded = encoder.Encode(*geog, geogs);
     geogs_data[i] = encoded;
   }
 
@@ -105,6 +107,7 @@ void S2DataCountriesScan(ClientContext& context, TableFunctionInput& data_p,
 
   s2geography::WKTReader reader;
   GeographyEncoder encoder;
+  InitGeographyEncoder(context, &encoder);
   Vector& names = output.data[0];
   Vector& continents = output.data[1];
   Vector& geogs = output.data[2];
@@ -120,7 +123,7 @@ void S2DataCountriesScan(ClientContext& context, TableFunctionInput& data_p,
     continents.SetValue(i - start, StringVector::AddString(names, country.continent));
 
     auto geog = reader.read_feature(country.geog_wkt);
-    string_t encoded = StringVector::AddStringOrBlob(geogs, encoder.Encode(*geog));
+    string_t encoded = encoder.Encode(*geog, geogs);
     geogs_data[i] = encoded;
   }
 
@@ -169,6 +172,7 @@ SELECT s2_data_country('Fiji') as country;
   static void ExecuteFn(DataChunk& args, ExpressionState& state, Vector& result) {
     s2geography::WKTReader reader;
     GeographyEncoder encoder;
+    InitGeographyEncoder(state.GetContext(), &encoder);
 
     std::unordered_map<std::string, const char*> cache;
     for (const T& item : ItemList<T>()) {
@@ -185,7 +189,7 @@ SELECT s2_data_country('Fiji') as country;
           }
 
           auto geog = reader.read_feature(item->second);
-          return StringVector::AddStringOrBlob(result, encoder.Encode(*geog));
+          return encoder.Encode(*geog, result);
         });
   }
 };
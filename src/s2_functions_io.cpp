@@ -1,15 +1,40 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
 
+#include "duckdb/common/file_system.hpp"
+#include "duckdb/common/operator/cast_operators.hpp"
+#include "duckdb/common/string_util.hpp"
+#include "duckdb/function/table_function.hpp"
+#include "duckdb/main/config.hpp"
 #include "duckdb/main/database.hpp"
 #include "duckdb/main/extension_util.hpp"
+#include "duckdb/parser/keyword_helper.hpp"
+#include "duckdb/parser/parser.hpp"
+#include "duckdb/parser/statement/select_statement.hpp"
+#include "duckdb/parser/tableref/subqueryref.hpp"
+
+#if defined(DUCKDB_HAS_ARROW_TYPE_EXTENSIONS)
+#include "duckdb/common/arrow/arrow_converter.hpp"
+#include "duckdb/common/arrow/arrow_type_extension.hpp"
+#include "duckdb/common/arrow/schema_metadata.hpp"
+#include "duckdb/function/table/arrow/arrow_duck_schema.hpp"
+#endif
 
 #include "s2/encoded_s2shape_index.h"
+#include "s2/s2latlng_rect.h"
+#include "s2/s2metrics.h"
+#include "s2/s2projections.h"
 #include "s2/s2shape_index_region.h"
 #include "s2/s2shapeutil_coding.h"
 #include "s2geography/geography.h"
 
+#include "s2_cell_ops.hpp"
+#include "s2_executor.hpp"
 #include "s2_geography_serde.hpp"
+#include "s2_settings.hpp"
 #include "s2_types.hpp"
-#include "s2geography/geoarrow.h"
 #include "s2geography/wkb.h"
 #include "s2geography/wkt-reader.h"
 #include "s2geography/wkt-writer.h"
@@ -21,45 +46,147 @@ namespace duckdb {
 namespace duckdb_s2 {
 
 struct S2GeogFromText {
+  // Shared by s2_geogfromtext() and the cast from VARCHAR, which may be
+  // evaluated without a client context (in which case the defaults are used)
+  struct LocalState {
+    explicit LocalState(optional_ptr<ClientContext> context) {
+      if (context) {
+        InitGeographyEncoder(*context, &encoder);
+      }
+    }
+
+    s2geography::WKTReader reader;
+    GeographyEncoder encoder;
+  };
+
   static void Register(DatabaseInstance& instance) {
     FunctionBuilder::RegisterScalar(
         instance, "s2_geogfromtext", [](ScalarFunctionBuilder& func) {
           func.AddVariant([](ScalarFunctionVariantBuilder& variant) {
             variant.AddParameter("wkt", LogicalType::VARCHAR);
             variant.SetReturnType(Types::GEOGRAPHY());
+            variant.SetLocalState<LocalState>();
             variant.SetFunction(ExecuteFn);
           });
 
-          func.SetDescription("Returns the geography from a WKT string.");
-          // TODO: Example
+          func.SetDescription(R"(
+Returns the geography from a WKT string.
+
+)");
+          func.SetExample(R"(
+SELECT s2_geogfromtext('POINT (-64 45)') AS geog;
+)");
 
           func.SetTag("ext", "geography");
           func.SetTag("category", "conversion");
         });
 
-    ExtensionUtil::RegisterCastFunction(instance, LogicalType::VARCHAR,
-                                        Types::GEOGRAPHY(), BoundCastInfo(ExecuteCast),
-                                        1);
+    ExtensionUtil::RegisterCastFunction(
+        instance, LogicalType::VARCHAR, Types::GEOGRAPHY(),
+        BoundCastInfo(ExecuteCast, nullptr, CastFunctionLocalState<LocalState>::Init), 1);
   }
 
   static inline void ExecuteFn(DataChunk& args, ExpressionState& state, Vector& result) {
-    Execute(args.data[0], result, args.size());
+    auto& local = ScalarFunctionLocalState<LocalState>::Get(state);
+    Execute(args.data[0], result, args.size(), local.reader, local.encoder);
   }
 
   static inline bool ExecuteCast(Vector& source, Vector& result, idx_t count,
                                  CastParameters& parameters) {
-    Execute(source, result, count);
+    auto& local = CastFunctionLocalState<LocalState>::Get(parameters);
+    Execute(source, result, count, local.reader, local.encoder);
     return true;
   }
 
-  static inline void Execute(Vector& source, Vector& result, idx_t count) {
-    GeographyEncoder encoder;
-    s2geography::WKTReader reader;
+  static inline void Execute(Vector& source, Vector& result, idx_t count,
+                             s2geography::WKTReader& reader, GeographyEncoder& encoder) {
+    ParsedPointEncoder point_encoder;
+
+    GeographyExecutor::ExecuteUnary<string_t, string_t>(
+        source, result, count, [&](string_t wkt) {
+          double lnglat[2];
+          string_t out;
+          if (TryParsePoint(wkt, lnglat) &&
+              point_encoder.TryEncode(lnglat, encoder, result, &out)) {
+            return out;
+          }
 
-    UnaryExecutor::Execute<string_t, string_t>(source, result, count, [&](string_t wkt) {
-      auto geog = reader.read_feature(wkt.GetData(), wkt.GetSize());
-      return StringVector::AddStringOrBlob(result, encoder.Encode(*geog));
-    });
+          auto geog = reader.read_feature(wkt.GetData(), wkt.GetSize());
+          return encoder.Encode(*geog, result);
+        });
+  }
+
+  // Parse POINT (x y) or POINT EMPTY (with any case or whitespace; EMPTY sets both
+  // coordinates to NaN). Returns false for anything else (including points with Z
+  // or M values), which is left to the WKTReader.
+  static bool TryParsePoint(string_t wkt, double* lnglat) {
+    const char* ptr = wkt.GetData();
+    const char* end = ptr + wkt.GetSize();
+
+    auto skip_whitespace = [&]() {
+      while (ptr < end && StringUtil::CharacterIsSpace(*ptr)) {
+        ptr++;
+      }
+    };
+
+    auto consume_word = [&](const char* word) {
+      const char* word_ptr = ptr;
+      for (; *word != '\0'; word++, word_ptr++) {
+        if (word_ptr == end || StringUtil::CharacterToUpper(*word_ptr) != *word) {
+          return false;
+        }
+      }
+
+      ptr = word_ptr;
+      return true;
+    };
+
+    auto consume_number = [&](double* out) {
+      const char* start = ptr;
+      while (ptr < end && !StringUtil::CharacterIsSpace(*ptr) && *ptr != ')') {
+        ptr++;
+      }
+
+      return ptr != start &&
+             TryCast::Operation<string_t, double>(
+                 string_t(start, static_cast<uint32_t>(ptr - start)), *out, true);
+    };
+
+    skip_whitespace();
+    if (!consume_word("POINT")) {
+      return false;
+    }
+
+    skip_whitespace();
+    if (consume_word("EMPTY")) {
+      skip_whitespace();
+      lnglat[0] = lnglat[1] = std::numeric_limits<double>::quiet_NaN();
+      return ptr == end;
+    }
+
+    if (ptr == end || *ptr != '(') {
+      return false;
+    }
+
+    ptr++;
+    skip_whitespace();
+    if (!consume_number(lnglat)) {
+      return false;
+    }
+
+    skip_whitespace();
+    if (!consume_number(lnglat + 1)) {
+      return false;
+    }
+
+    skip_whitespace();
+    if (ptr == end || *ptr != ')') {
+      return false;
+    }
+
+    ptr++;
+    skip_whitespace();
+    return ptr == end;
   }
 };
 
@@ -70,6 +197,7 @@ struct S2AsText {
           func.AddVariant([](ScalarFunctionVariantBuilder& variant) {
             variant.AddParameter("geog", Types::GEOGRAPHY());
             variant.SetReturnType(LogicalType::VARCHAR);
+            variant.SetLocalState<LocalState>();
             variant.SetFunction(ExecuteFn);
           });
 
@@ -99,6 +227,7 @@ SELECT s2_astext(s2_data_city('Vancouver'));
             variant.AddParameter("geog", Types::GEOGRAPHY());
             variant.AddParameter("precision", LogicalType::TINYINT);
             variant.SetReturnType(LogicalType::VARCHAR);
+            variant.SetLocalState<LocalState>();
             variant.SetFunction(ExecuteFnPrec);
           });
 
@@ -122,8 +251,25 @@ SELECT s2_format(s2_data_city('Vancouver'), 1);
                                         1);
   }
 
+  // The writer is only recreated if the precision changes
+  struct LocalState {
+    GeographyDecoder decoder;
+    unique_ptr<s2geography::WKTWriter> writer;
+    int8_t precision{-1};
+
+    s2geography::WKTWriter& Writer(int8_t precision_p) {
+      if (!writer || precision != precision_p) {
+        writer = make_uniq<s2geography::WKTWriter>(precision_p);
+        precision = precision_p;
+      }
+
+      return *writer;
+    }
+  };
+
   static inline void ExecuteFn(DataChunk& args, ExpressionState& state, Vector& result) {
-    Execute(args.data[0], result, args.size());
+    auto& local = ScalarFunctionLocalState<LocalState>::Get(state);
+    Execute(args.data[0], result, args.size(), local.decoder, local.Writer(-1));
   }
 
   static inline void ExecuteFnPrec(DataChunk& args, ExpressionState& state,
@@ -133,21 +279,23 @@ SELECT s2_format(s2_data_city('Vancouver'), 1);
       throw InvalidInputException("Can't use s2_format() with non-constant precision");
     }
 
-    Execute(args.data[0], result, args.size(), precision.GetValue(0).GetValue<int8_t>());
+    auto& local = ScalarFunctionLocalState<LocalState>::Get(state);
+    Execute(args.data[0], result, args.size(), local.decoder,
+            local.Writer(precision.GetValue(0).GetValue<int8_t>()));
   }
 
   static inline bool ExecuteCast(Vector& source, Vector& result, idx_t count,
                                  CastParameters& parameters) {
-    Execute(source, result, count);
+    GeographyDecoder decoder;
+    s2geography::WKTWriter writer(-1);
+    Execute(source, result, count, decoder, writer);
     return true;
   }
 
   static inline void Execute(Vector& source, Vector& result, idx_t count,
-                             int8_t precision = -1) {
-    GeographyDecoder decoder;
-    s2geography::WKTWriter writer(precision);
+                             GeographyDecoder& decoder, s2geography::WKTWriter& writer) {
 
-    UnaryExecutor::Execute<string_t, string_t>(
+    GeographyExecutor::ExecuteUnary<string_t, string_t>(
         source, result, count, [&](string_t geog_str) {
           decoder.DecodeTag(geog_str);
           if (decoder.tag.kind == s2geography::GeographyKind::SHAPE_INDEX) {
@@ -155,20 +303,29 @@ SELECT s2_format(s2_data_city('Vancouver'), 1);
                 result, std::string("<S2ShapeIndex ") +
                             std::to_string(geog_str.GetSize()) + " b>");
           }
-          auto geog = decoder.Decode(geog_str);
-          std::string wkt = writer.write_feature(*geog);
+          std::string wkt = writer.write_feature(decoder.DecodeInPlace(geog_str));
           return StringVector::AddString(result, wkt);
         });
   }
 };
 
 struct S2GeogFromWKB {
+  struct LocalState {
+    explicit LocalState(ClientContext& context) {
+      InitGeographyEncoder(context, &encoder);
+    }
+
+    s2geography::WKBReader reader;
+    GeographyEncoder encoder;
+  };
+
   static void Register(DatabaseInstance& instance) {
     FunctionBuilder::RegisterScalar(
         instance, "s2_geogfromwkb", [](ScalarFunctionBuilder& func) {
           func.AddVariant([](ScalarFunctionVariantBuilder& variant) {
             variant.AddParameter("wkb", LogicalType::BLOB);
             variant.SetReturnType(Types::GEOGRAPHY());
+            variant.SetLocalState<LocalState>();
             variant.SetFunction(ExecuteFn);
           });
 
@@ -179,6 +336,7 @@ The input WKB blog is assumed to have longitude/latitude coordinates and have
 spherical edges. If edges are long and the input had a different edge type,
 the resulting GEOGRAPHY may be invalid or represent a different location than
 intended.
+
 )");
           func.SetExample(R"(
 SELECT s2_geogfromwkb(s2_aswkb(s2_data_city('Toronto'))) as geog;
@@ -190,28 +348,43 @@ SELECT s2_geogfromwkb(s2_aswkb(s2_data_city('Toronto'))) as geog;
   }
 
   static inline void ExecuteFn(DataChunk& args, ExpressionState& state, Vector& result) {
-    Execute(args.data[0], result, args.size());
+    auto& local = ScalarFunctionLocalState<LocalState>::Get(state);
+    Execute(args.data[0], result, args.size(), local.reader, local.encoder);
   }
 
-  static inline void Execute(Vector& source, Vector& result, idx_t count) {
-    s2geography::WKBReader reader;
-    GeographyEncoder encoder;
+  static inline void Execute(Vector& source, Vector& result, idx_t count,
+                             s2geography::WKBReader& reader, GeographyEncoder& encoder) {
+    ParsedPointEncoder point_encoder;
+
+    GeographyExecutor::ExecuteUnary<string_t, string_t>(
+        source, result, count, [&](string_t wkb) {
+          double lnglat[2];
+          string_t out;
+          if (TryLngLatFromPointWKB(wkb, lnglat) &&
+              point_encoder.TryEncode(lnglat, encoder, result, &out)) {
+            return out;
+          }
 
-    UnaryExecutor::Execute<string_t, string_t>(source, result, count, [&](string_t wkb) {
-      std::unique_ptr<s2geography::Geography> geog =
-          reader.ReadFeature(std::string_view(wkb.GetData(), wkb.GetSize()));
-      return StringVector::AddStringOrBlob(result, encoder.Encode(*geog));
-    });
+          std::unique_ptr<s2geography::Geography> geog =
+              reader.ReadFeature(std::string_view(wkb.GetData(), wkb.GetSize()));
+          return encoder.Encode(*geog, result);
+        });
   }
 };
 
 struct S2AsWKB {
+  struct LocalState {
+    GeographyDecoder decoder;
+    s2geography::WKBWriter writer;
+  };
+
   static void Register(DatabaseInstance& instance) {
     FunctionBuilder::RegisterScalar(
         instance, "s2_aswkb", [](ScalarFunctionBuilder& func) {
           func.AddVariant([](ScalarFunctionVariantBuilder& variant) {
             variant.AddParameter("geog", Types::GEOGRAPHY());
             variant.SetReturnType(LogicalType::BLOB);
+            variant.SetLocalState<LocalState>();
             variant.SetFunction(ExecuteFn);
           });
 
@@ -235,27 +408,42 @@ SELECT s2_aswkb(s2_data_city('Toronto')) as wkb;
   }
 
   static inline void ExecuteFn(DataChunk& args, ExpressionState& state, Vector& result) {
-    Execute(args.data[0], result, args.size());
+    auto& local = ScalarFunctionLocalState<LocalState>::Get(state);
+    Execute(args.data[0], result, args.size(), local.decoder, local.writer);
   }
 
-  static inline void Execute(Vector& source, Vector& result, idx_t count) {
-    GeographyDecoder decoder;
-    s2geography::WKBWriter writer;
+  static inline void Execute(Vector& source, Vector& result, idx_t count,
+                             GeographyDecoder& decoder, s2geography::WKBWriter& writer) {
 
-    UnaryExecutor::Execute<string_t, string_t>(source, result, count, [&](string_t wkb) {
-      std::unique_ptr<s2geography::Geography> geog = decoder.Decode(wkb);
-      return StringVector::AddStringOrBlob(result, writer.WriteFeature(*geog));
-    });
+    GeographyExecutor::ExecuteUnary<string_t, string_t>(
+        source, result, count, [&](string_t wkb) {
+          auto& geog = decoder.DecodeInPlace(wkb);
+          return StringVector::AddStringOrBlob(result, writer.WriteFeature(geog));
+        });
   }
 };
 
 struct S2GeogPrepare {
+  struct LocalState {
+    explicit LocalState(ClientContext& context)
+        : threshold(GetPrepareThreshold(context)) {
+      InitGeographyEncoder(context, &encoder);
+      InitShapeIndexOptions(context, &index_options);
+    }
+
+    GeographyDecoder decoder;
+    GeographyEncoder encoder;
+    MutableS2ShapeIndex::Options index_options;
+    idx_t threshold;
+  };
+
   static void Register(DatabaseInstance& instance) {
     FunctionBuilder::RegisterScalar(
         instance, "s2_prepare", [](ScalarFunctionBuilder& func) {
           func.AddVariant([](ScalarFunctionVariantBuilder& variant) {
             variant.AddParameter("geog", Types::GEOGRAPHY());
             variant.SetReturnType(Types::GEOGRAPHY());
+            variant.SetLocalState<LocalState>();
             variant.SetFunction(ExecuteFn);
           });
 
@@ -269,7 +457,10 @@ this operation builds a cell-based index on the edges of the geography that
 would otherwise have to occur on every intersection check.
 
 This function returns its input for very small geographies (e.g., points)
-that do not benefit from this operation.
+that do not benefit from this operation. The size below which geographies are
+not indexed and the maximum number of edges in each cell of the index can be
+set with the `s2_prepare_threshold` and `s2_index_max_edges_per_cell`
+settings.
 )");
           func.SetExample(R"(
 SELECT s2_prepare(s2_data_country('Fiji'));
@@ -290,38 +481,800 @@ LIMIT 5;
   }
 
   static inline void ExecuteFn(DataChunk& args, ExpressionState& state, Vector& result) {
-    Execute(args.data[0], result, args.size());
+    auto& local = ScalarFunctionLocalState<LocalState>::Get(state);
+    Execute(args.data[0], result, args.size(), local.decoder, local.encoder,
+            local.index_options, local.threshold);
   }
 
-  static inline void Execute(Vector& source, Vector& result, idx_t count) {
-    GeographyDecoder decoder;
-    GeographyEncoder encoder;
+  static inline void Execute(Vector& source, Vector& result, idx_t count,
+                             GeographyDecoder& decoder, GeographyEncoder& encoder,
+                             const MutableS2ShapeIndex::Options& index_options,
+                             idx_t threshold) {
 
-    UnaryExecutor::Execute<string_t, string_t>(
+    GeographyExecutor::ExecuteUnary<string_t, string_t>(
         source, result, count, [&](string_t geog_str) {
           decoder.DecodeTag(geog_str);
 
           // For small geographies or something that is already prepared, don't
-          // trigger a new index. 64 bytes is arbitrary here (should be tuned).
+          // trigger a new index (see s2_prepare_threshold)
           if (decoder.tag.kind == s2geography::GeographyKind::SHAPE_INDEX ||
-              geog_str.GetSize() < 64) {
+              geog_str.GetSize() < threshold) {
             // Maybe a way to avoid copying geog_str?
             return StringVector::AddStringOrBlob(result, geog_str);
           }
 
-          std::unique_ptr<s2geography::Geography> geog = decoder.Decode(geog_str);
-          s2geography::ShapeIndexGeography index_geog(*geog);
-          return StringVector::AddStringOrBlob(result, encoder.Encode(index_geog));
+          auto& geog = decoder.DecodeInPlace(geog_str);
+          s2geography::ShapeIndexGeography index_geog(index_options);
+          index_geog.Add(geog);
+          return encoder.Encode(index_geog, result);
         });
   }
 };
 
+#if defined(DUCKDB_HAS_ARROW_TYPE_EXTENSIONS)
+// Exports GEOGRAPHY columns as geoarrow.wkb (e.g., from fetch_arrow_table()) and
+// imports geoarrow.wkb arrays as GEOGRAPHY (e.g., from arrow_scan()). The
+// conversions are applied to a whole vector at a time. DuckDB's Arrow extension
+// callbacks convert to and from a DuckDB BLOB vector (which DuckDB then copies to
+// or from the Arrow array), so the WKB is written one value at a time into that
+// vector rather than by s2geography's GeoArrow writer (which writes an
+// ArrowArray directly).
+struct GeoArrowWKB {
+  static unique_ptr<ArrowType> GetType(const ArrowSchema& schema,
+                                       const ArrowSchemaMetadata& schema_metadata) {
+    const auto format = string(schema.format);
+    if (format == "z") {
+      return make_uniq<ArrowType>(
+          Types::GEOGRAPHY(), make_uniq<ArrowStringInfo>(ArrowVariableSizeType::NORMAL));
+    } else if (format == "Z") {
+      return make_uniq<ArrowType>(
+          Types::GEOGRAPHY(),
+          make_uniq<ArrowStringInfo>(ArrowVariableSizeType::SUPER_SIZE));
+    } else if (format == "vz") {
+      return make_uniq<ArrowType>(
+          Types::GEOGRAPHY(), make_uniq<ArrowStringInfo>(ArrowVariableSizeType::VIEW));
+    }
+
+    throw InvalidInputException(
+        "Arrow storage type \"%s\" not supported for geoarrow.wkb", format.c_str());
+  }
+
+  static void PopulateSchema(DuckDBArrowSchemaHolder& root_holder, ArrowSchema& schema,
+                             const LogicalType& type, ClientContext& context,
+                             const ArrowTypeExtension& extension) {
+    ArrowSchemaMetadata schema_metadata;
+    schema_metadata.AddOption(ArrowSchemaMetadata::ARROW_EXTENSION_NAME, "geoarrow.wkb");
+    schema_metadata.AddOption(ArrowSchemaMetadata::ARROW_METADATA_KEY,
+                              R"({"edges": "spherical"})");
+    root_holder.metadata_info.emplace_back(schema_metadata.SerializeMetadata());
+    schema.metadata = root_holder.metadata_info.back().get();
+
+    const auto options = context.GetClientProperties();
+    if (options.arrow_offset_size == ArrowOffsetSize::LARGE) {
+      schema.format = "Z";
+    } else {
+      schema.format = "z";
+    }
+  }
+
+  // These callbacks have no local state, so the reader, writer, and coders are
+  // reused per thread rather than created for every vector (only the encoder's
+  // settings are refreshed, since they may change between queries)
+  static void ArrowToDuck(ClientContext& context, Vector& source, Vector& result,
+                          idx_t count) {
+    static thread_local s2geography::WKBReader reader;
+    static thread_local GeographyEncoder encoder;
+    InitGeographyEncoder(context, &encoder);
+    S2GeogFromWKB::Execute(source, result, count, reader, encoder);
+  }
+
+  static void DuckToArrow(ClientContext& context, Vector& source, Vector& result,
+                          idx_t count) {
+    static thread_local GeographyDecoder decoder;
+    static thread_local s2geography::WKBWriter writer;
+    S2AsWKB::Execute(source, result, count, decoder, writer);
+  }
+
+  static void Register(DatabaseInstance& instance) {
+    auto& config = DBConfig::GetConfig(instance);
+    config.RegisterArrowExtension(
+        {"geoarrow.wkb", PopulateSchema, GetType,
+         make_shared_ptr<ArrowTypeExtensionData>(Types::GEOGRAPHY(), LogicalType::BLOB,
+                                                 ArrowToDuck, DuckToArrow)});
+  }
+};
+#endif
+
+// Lines of newline-delimited files are read in blocks of about this many bytes
+// that are scanned in parallel (one or more blocks per file)
+static constexpr int64_t kDefaultReadBlockSize = 8 * 1024 * 1024;
+
+struct S2ReadTask {
+  idx_t file_idx;
+  idx_t start;
+  idx_t end;
+};
+
+class S2ReadBindData : public TableFunctionData {
+ public:
+  vector<string> files;
+  idx_t block_size{kDefaultReadBlockSize};
+
+  // If delim is set, each line holds num_fields delimited fields (e.g., as written
+  // by COPY ... (FORMAT CSV)) of which one is the geometry and the rest are
+  // returned as VARCHAR attribute columns
+  bool delimited{false};
+  char delim{','};
+  bool header{false};
+  idx_t num_fields{1};
+  idx_t geometry_field{0};
+  vector<idx_t> attribute_fields;
+};
+
+class S2ReadGlobalState : public GlobalTableFunctionState {
+ public:
+  vector<S2ReadTask> tasks;
+  std::atomic<idx_t> next_task{0};
+  vector<column_t> column_ids;
+  // The position in the output of each field (or DConstants::INVALID_INDEX if it
+  // was not requested)
+  vector<idx_t> field_outputs;
+
+  idx_t MaxThreads() const override { return MaxValue<idx_t>(tasks.size(), 1); }
+};
+
+struct DelimitedField {
+  string_t value;
+  bool is_null;
+};
+
+// Split line into fields separated by delim. A field may be enclosed in double
+// quotes, within which delim has no special meaning and "" is a literal quote.
+// Quoted fields are unescaped in place (which is why line must be writable).
+// Fields that are empty and unquoted are NULL.
+static void SplitFields(string_t& line, char delim, vector<DelimitedField>* fields) {
+  fields->clear();
+  char* data = line.GetDataWriteable();
+  idx_t size = line.GetSize();
+  idx_t pos = 0;
+
+  while (true) {
+    char* out = data + pos;
+    idx_t out_size = 0;
+    bool quoted = pos < size && data[pos] == '"';
+    if (quoted) {
+      pos++;
+      while (pos < size) {
+        if (data[pos] == '"') {
+          if (pos + 1 < size && data[pos + 1] == '"') {
+            out[out_size++] = '"';
+            pos += 2;
+            continue;
+          }
+
+          pos++;
+          break;
+        }
+
+        out[out_size++] = data[pos++];
+      }
+    }
+
+    // For a quoted field, anything between the closing quote and the delimiter
+    // is kept as is
+    while (pos < size && data[pos] != delim) {
+      out[out_size++] = data[pos++];
+    }
+
+    fields->push_back(
+        {string_t(out, static_cast<uint32_t>(out_size)), !quoted && out_size == 0});
+    if (pos >= size) {
+      break;
+    }
+
+    pos++;
+  }
+}
+
+// Each thread reads one block at a time with its own file handle, readers, and
+// encoder. A line belongs to the block in which it starts: a block skips the
+// partial line that began before its start (or a header) and reads past its end
+// to finish its last line.
+class S2ReadLocalState : public LocalTableFunctionState {
+ public:
+  s2geography::WKTReader wkt_reader;
+  s2geography::WKBReader wkb_reader;
+  GeographyEncoder encoder;
+  vector<DelimitedField> fields;
+  bool has_task{false};
+  idx_t file_idx{0};
+
+  void Begin(ClientContext& context, const string& path, const S2ReadTask& task,
+             bool skip_header) {
+    if (!handle_ || path != path_) {
+      auto& fs = FileSystem::GetFileSystem(context);
+      handle_ = fs.OpenFile(path, FileFlags::FILE_FLAGS_READ);
+      path_ = path;
+    }
+
+    has_task = true;
+    file_idx = task.file_idx;
+    file_size_ = static_cast<idx_t>(handle_->GetFileSize());
+
+    // Start one byte early so that we know whether the first line starts
+    // exactly at task.start
+    read_start_ = task.start == 0 ? 0 : task.start - 1;
+    buffer_.resize(task.end - read_start_);
+    handle_->Read(&buffer_[0], buffer_.size(), read_start_);
+
+    pos_ = 0;
+    if (task.start > 0 || skip_header) {
+      auto newline = buffer_.find('\n');
+      pos_ = newline == std::string::npos ? buffer_.size() : newline + 1;
+    }
+  }
+
+  // Returns the next non-blank line of this block, which is valid until the
+  // next call to Begin()
+  bool NextLine(string_t* line, int64_t* offset) {
+    while (pos_ < buffer_.size()) {
+      idx_t start = pos_;
+      const char* data;
+      idx_t size;
+
+      auto newline = buffer_.find('\n', start);
+      if (newline != std::string::npos) {
+        data = buffer_.data() + start;
+        size = newline - start;
+        pos_ = newline + 1;
+      } else {
+        ReadLastLine(start);
+        data = last_line_.data();
+        size = last_line_.size();
+        pos_ = buffer_.size();
+      }
+
+      if (size > 0 && data[size - 1] == '\r') {
+        size--;
+      }
+
+      bool blank = true;
+      for (idx_t i = 0; i < size; i++) {
+        if (!StringUtil::CharacterIsSpace(data[i])) {
+          blank = false;
+          break;
+        }
+      }
+
+      if (blank) {
+        continue;
+      }
+
+      *line = string_t(data, static_cast<uint32_t>(size));
+      *offset = static_cast<int64_t>(read_start_ + start);
+      return true;
+    }
+
+    return false;
+  }
+
+ private:
+  unique_ptr<FileHandle> handle_;
+  string path_;
+  idx_t file_size_{0};
+  idx_t read_start_{0};
+  idx_t pos_{0};
+  std::string buffer_;
+  std::string last_line_;
+
+  void ReadLastLine(idx_t start) {
+    last_line_.assign(buffer_, start, std::string::npos);
+
+    char chunk[4096];
+    idx_t location = read_start_ + buffer_.size();
+    while (location < file_size_) {
+      idx_t chunk_size = MinValue<idx_t>(sizeof(chunk), file_size_ - location);
+      handle_->Read(chunk, chunk_size, location);
+      location += chunk_size;
+
+      const char* newline = std::find(chunk, chunk + chunk_size, '\n');
+      last_line_.append(chunk, newline - chunk);
+      if (newline != chunk + chunk_size) {
+        break;
+      }
+    }
+  }
+};
+
+// Shared implementation of s2_read_wkt() and s2_read_wkb(), where Format
+// provides the function Name() and how to parse a vector of lines.
+template <typename Format>
+struct S2ReadLines {
+  static void Register(DatabaseInstance& instance) {
+    TableFunction func(Format::Name(), {LogicalType::VARCHAR}, Scan, Bind, InitGlobal,
+                       InitLocal);
+    func.named_parameters["block_size"] = LogicalType::BIGINT;
+    func.named_parameters["delim"] = LogicalType::VARCHAR;
+    func.named_parameters["header"] = LogicalType::BOOLEAN;
+    func.named_parameters["geometry_column"] = LogicalType::VARCHAR;
+    func.projection_pushdown = true;
+    ExtensionUtil::RegisterFunction(instance, func);
+  }
+
+  static unique_ptr<FunctionData> Bind(ClientContext& context,
+                                       TableFunctionBindInput& input,
+                                       vector<LogicalType>& return_types,
+                                       vector<string>& names) {
+    if (input.inputs[0].IsNull()) {
+      throw BinderException("%s(): file glob must not be NULL", Format::Name());
+    }
+
+    auto result = make_uniq<S2ReadBindData>();
+    auto& fs = FileSystem::GetFileSystem(context);
+    result->files = fs.GlobFiles(StringValue::Get(input.inputs[0]), context,
+                                 FileGlobOptions::DISALLOW_EMPTY);
+
+    string geometry_column;
+    for (auto& param : input.named_parameters) {
+      if (param.first == "block_size") {
+        int64_t block_size = param.second.GetValue<int64_t>();
+        if (block_size <= 0) {
+          throw BinderException("%s(): block_size must be positive but got %d",
+                                Format::Name(), block_size);
+        }
+
+        result->block_size = static_cast<idx_t>(block_size);
+      } else if (param.first == "delim") {
+        auto delim = param.second.GetValue<string>();
+        if (delim.size() != 1 || delim[0] == '"' || delim[0] == '\n' ||
+            delim[0] == '\r') {
+          throw BinderException(
+              "%s(): delim must be a single character other than a quote or newline "
+              "but got '%s'",
+              Format::Name(), delim);
+        }
+
+        result->delimited = true;
+        result->delim = delim[0];
+      } else if (param.first == "header") {
+        result->header = param.second.GetValue<bool>();
+      } else if (param.first == "geometry_column") {
+        geometry_column = param.second.GetValue<string>();
+      }
+    }
+
+    if (!result->delimited && (result->header || !geometry_column.empty())) {
+      throw BinderException("%s(): header and geometry_column require delim",
+                            Format::Name());
+    }
+
+    names.push_back("geog");
+    return_types.push_back(Types::GEOGRAPHY());
+
+    if (result->delimited) {
+      auto field_names = ReadFieldNames(context, *result);
+      result->num_fields = field_names.size();
+
+      if (!geometry_column.empty()) {
+        auto it = std::find(field_names.begin(), field_names.end(), geometry_column);
+        if (it == field_names.end()) {
+          throw BinderException("%s(): geometry_column '%s' not found in '%s'",
+                                Format::Name(), geometry_column, result->files[0]);
+        }
+
+        result->geometry_field = static_cast<idx_t>(it - field_names.begin());
+      }
+
+      for (idx_t i = 0; i < field_names.size(); i++) {
+        if (i != result->geometry_field) {
+          result->attribute_fields.push_back(i);
+          names.push_back(field_names[i]);
+          return_types.push_back(LogicalType::VARCHAR);
+        }
+      }
+    }
+
+    names.push_back("filename");
+    names.push_back("file_offset");
+    return_types.push_back(LogicalType::VARCHAR);
+    return_types.push_back(LogicalType::BIGINT);
+    return std::move(result);
+  }
+
+  // The names of the fields in the first line of the first file: the header if
+  // there is one or column0, column1, etc. otherwise
+  static vector<string> ReadFieldNames(ClientContext& context,
+                                       const S2ReadBindData& bind_data) {
+    auto& fs = FileSystem::GetFileSystem(context);
+    auto handle = fs.OpenFile(bind_data.files[0], FileFlags::FILE_FLAGS_READ);
+    idx_t file_size = static_cast<idx_t>(handle->GetFileSize());
+
+    std::string line;
+    char chunk[4096];
+    idx_t location = 0;
+    while (location < file_size) {
+      idx_t chunk_size = MinValue<idx_t>(sizeof(chunk), file_size - location);
+      handle->Read(chunk, chunk_size, location);
+      location += chunk_size;
+
+      const char* newline = std::find(chunk, chunk + chunk_size, '\n');
+      line.append(chunk, newline - chunk);
+      if (newline != chunk + chunk_size) {
+        break;
+      }
+    }
+
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+
+    if (line.empty()) {
+      throw BinderException(
+          "%s(): first line of '%s' must not be empty when delim is set",
+          Format::Name(), bind_data.files[0]);
+    }
+
+    string_t line_str(&line[0], static_cast<uint32_t>(line.size()));
+    vector<DelimitedField> fields;
+    SplitFields(line_str, bind_data.delim, &fields);
+
+    vector<string> names;
+    for (idx_t i = 0; i < fields.size(); i++) {
+      if (bind_data.header && !fields[i].is_null) {
+        names.push_back(fields[i].value.GetString());
+      } else {
+        names.push_back("column" + std::to_string(i));
+      }
+    }
+
+    return names;
+  }
+
+  static unique_ptr<GlobalTableFunctionState> InitGlobal(ClientContext& context,
+                                                         TableFunctionInitInput& input) {
+    auto& bind_data = input.bind_data->Cast<S2ReadBindData>();
+    auto result = make_uniq<S2ReadGlobalState>();
+    result->column_ids = input.column_ids;
+
+    result->field_outputs.assign(bind_data.num_fields, DConstants::INVALID_INDEX);
+    for (idx_t i = 0; i < input.column_ids.size(); i++) {
+      auto column_id = input.column_ids[i];
+      if (column_id >= 1 && column_id <= bind_data.attribute_fields.size()) {
+        result->field_outputs[bind_data.attribute_fields[column_id - 1]] = i;
+      }
+    }
+
+    auto& fs = FileSystem::GetFileSystem(context);
+    for (idx_t i = 0; i < bind_data.files.size(); i++) {
+      auto handle = fs.OpenFile(bind_data.files[i], FileFlags::FILE_FLAGS_READ);
+      idx_t file_size = static_cast<idx_t>(handle->GetFileSize());
+      for (idx_t start = 0; start < file_size; start += bind_data.block_size) {
+        idx_t end = MinValue<idx_t>(start + bind_data.block_size, file_size);
+        result->tasks.push_back({i, start, end});
+      }
+    }
+
+    return std::move(result);
+  }
+
+  static unique_ptr<LocalTableFunctionState> InitLocal(
+      ExecutionContext& context, TableFunctionInitInput& input,
+      GlobalTableFunctionState* global_state) {
+    auto result = make_uniq<S2ReadLocalState>();
+    InitGeographyEncoder(context.client, &result->encoder);
+    return std::move(result);
+  }
+
+  static void Scan(ClientContext& context, TableFunctionInput& data_p,
+                   DataChunk& output) {
+    auto& bind_data = data_p.bind_data->Cast<S2ReadBindData>();
+    auto& global = data_p.global_state->Cast<S2ReadGlobalState>();
+    auto& local = data_p.local_state->Cast<S2ReadLocalState>();
+
+    // A chunk never spans more than one block, so the lines can point directly
+    // into the block's buffer and the filename is constant
+    Vector lines(LogicalType::VARCHAR);
+    auto lines_data = FlatVector::GetData<string_t>(lines);
+    int64_t offsets[STANDARD_VECTOR_SIZE];
+
+    idx_t count = 0;
+    idx_t file_idx = 0;
+    while (count == 0) {
+      if (!local.has_task) {
+        idx_t task_idx = global.next_task++;
+        if (task_idx >= global.tasks.size()) {
+          output.SetCardinality(0);
+          return;
+        }
+
+        const S2ReadTask& task = global.tasks[task_idx];
+        local.Begin(context, bind_data.files[task.file_idx], task, bind_data.header);
+      }
+
+      file_idx = local.file_idx;
+      while (count < STANDARD_VECTOR_SIZE &&
+             local.NextLine(lines_data + count, offsets + count)) {
+        count++;
+      }
+
+      if (count < STANDARD_VECTOR_SIZE) {
+        local.has_task = false;
+      }
+    }
+
+    if (bind_data.delimited) {
+      SplitLines(bind_data, global, local, lines, output, count, file_idx, offsets);
+    }
+
+    // Only do the work required for the columns that were requested (attribute
+    // columns were filled when the lines were split)
+    idx_t filename_column = bind_data.attribute_fields.size() + 1;
+    for (idx_t i = 0; i < global.column_ids.size(); i++) {
+      auto column_id = global.column_ids[i];
+      if (column_id == 0) {
+        Format::Parse(lines, output.data[i], count, local);
+      } else if (column_id == filename_column) {
+        output.data[i].Reference(Value(bind_data.files[file_idx]));
+      } else if (column_id == filename_column + 1) {
+        memcpy(FlatVector::GetData<int64_t>(output.data[i]), offsets,
+               count * sizeof(int64_t));
+      }
+
+      // Anything else is an attribute or e.g., the row id requested by count(*)
+    }
+
+    output.SetCardinality(count);
+  }
+
+  // Replace each line with its geometry field (which may be NULL) and copy the
+  // requested attribute fields to the output
+  static void SplitLines(const S2ReadBindData& bind_data, const S2ReadGlobalState& global,
+                         S2ReadLocalState& local, Vector& lines, DataChunk& output,
+                         idx_t count, idx_t file_idx, const int64_t* offsets) {
+    auto lines_data = FlatVector::GetData<string_t>(lines);
+    auto& lines_validity = FlatVector::Validity(lines);
+
+    for (idx_t row = 0; row < count; row++) {
+      SplitFields(lines_data[row], bind_data.delim, &local.fields);
+      if (local.fields.size() != bind_data.num_fields) {
+        throw InvalidInputException(
+            "%s(): expected %d fields but got %d in line at offset %d of '%s'",
+            Format::Name(), bind_data.num_fields, local.fields.size(), offsets[row],
+            bind_data.files[file_idx]);
+      }
+
+      for (idx_t j = 0; j < local.fields.size(); j++) {
+        const DelimitedField& field = local.fields[j];
+        if (j == bind_data.geometry_field) {
+          lines_data[row] = field.value;
+          if (field.is_null) {
+            lines_validity.SetInvalid(row);
+          }
+
+          continue;
+        }
+
+        idx_t output_idx = global.field_outputs[j];
+        if (output_idx == DConstants::INVALID_INDEX) {
+          continue;
+        }
+
+        Vector& attribute = output.data[output_idx];
+        if (field.is_null) {
+          FlatVector::SetNull(attribute, row, true);
+        } else {
+          FlatVector::GetData<string_t>(attribute)[row] =
+              StringVector::AddString(attribute, field.value);
+        }
+      }
+    }
+  }
+};
+
+struct S2ReadWKT {
+  static const char* Name() { return "s2_read_wkt"; }
+
+  static void Parse(Vector& lines, Vector& result, idx_t count, S2ReadLocalState& local) {
+    S2GeogFromText::Execute(lines, result, count, local.wkt_reader, local.encoder);
+  }
+};
+
+struct S2ReadWKB {
+  static const char* Name() { return "s2_read_wkb"; }
+
+  static void Parse(Vector& lines, Vector& result, idx_t count, S2ReadLocalState& local) {
+    Vector blobs(LogicalType::BLOB, count);
+    auto lines_data = FlatVector::GetData<string_t>(lines);
+    auto blobs_data = FlatVector::GetData<string_t>(blobs);
+    auto& lines_validity = FlatVector::Validity(lines);
+    FlatVector::SetValidity(blobs, lines_validity);
+    for (idx_t i = 0; i < count; i++) {
+      if (lines_validity.RowIsValid(i)) {
+        blobs_data[i] = HexToBlob(lines_data[i], blobs);
+      }
+    }
+
+    S2GeogFromWKB::Execute(blobs, result, count, local.wkb_reader, local.encoder);
+  }
+
+  static int HexValue(char c) {
+    if (c >= '0' && c <= '9') {
+      return c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+      return c - 'a' + 10;
+    } else if (c >= 'A' && c <= 'F') {
+      return c - 'A' + 10;
+    } else {
+      return -1;
+    }
+  }
+
+  static string_t HexToBlob(string_t hex, Vector& result) {
+    const char* data = hex.GetData();
+    idx_t size = hex.GetSize();
+    while (size > 0 && StringUtil::CharacterIsSpace(data[size - 1])) {
+      size--;
+    }
+
+    if (size % 2 != 0) {
+      throw InvalidInputException("Expected hex-encoded WKB but got '%s'",
+                                  hex.GetString());
+    }
+
+    string_t out = StringVector::EmptyString(result, size / 2);
+    auto out_data = reinterpret_cast<uint8_t*>(out.GetDataWriteable());
+    for (idx_t i = 0; i < size / 2; i++) {
+      int high = HexValue(data[2 * i]);
+      int low = HexValue(data[2 * i + 1]);
+      if (high < 0 || low < 0) {
+        throw InvalidInputException("Expected hex-encoded WKB but got '%s'",
+                                    hex.GetString());
+      }
+
+      out_data[i] = static_cast<uint8_t>((high << 4) | low);
+    }
+
+    out.Finalize();
+    return out;
+  }
+};
+
+// s2_read_geoparquet() is rewritten into a read_parquet() query such that the
+// bbox covering column can be used to skip row groups before any WKB is parsed
+struct S2ReadGeoParquet {
+  static void Register(DatabaseInstance& instance) {
+    TableFunction func("s2_read_geoparquet", {LogicalType::VARCHAR}, nullptr, nullptr);
+    func.bind_replace = BindReplace;
+    func.named_parameters["filter"] = Types::GEOGRAPHY();
+    func.named_parameters["geometry_column"] = LogicalType::VARCHAR;
+    func.named_parameters["bbox_column"] = LogicalType::VARCHAR;
+    ExtensionUtil::RegisterFunction(instance, func);
+  }
+
+  static unique_ptr<TableRef> BindReplace(ClientContext& context,
+                                          TableFunctionBindInput& input) {
+    if (input.inputs[0].IsNull()) {
+      throw BinderException("s2_read_geoparquet(): file glob must not be NULL");
+    }
+
+    string geometry_column = "geometry";
+    string bbox_column = "bbox";
+    Value filter;
+    for (auto& param : input.named_parameters) {
+      if (param.first == "filter") {
+        filter = param.second;
+      } else if (param.first == "geometry_column") {
+        geometry_column = StringValue::Get(param.second);
+      } else if (param.first == "bbox_column") {
+        bbox_column = StringValue::Get(param.second);
+      }
+    }
+
+    string geometry = KeywordHelper::WriteOptionallyQuoted(geometry_column);
+    string files = KeywordHelper::WriteQuoted(StringValue::Get(input.inputs[0]), '\'');
+    string sql;
+    if (filter.IsNull()) {
+      sql = StringUtil::Format(
+          "SELECT * REPLACE (s2_geogfromwkb(%s) AS %s) FROM read_parquet(%s)", geometry,
+          geometry, files);
+    } else {
+      // The bbox conditions are on the raw columns such that they are pushed into
+      // the Parquet reader and the exact test is on the converted geometry such
+      // that each row is only converted once. The conversion is wrapped in
+      // unnest() because filter pushdown would otherwise substitute it for the
+      // column in the exact test (i.e., convert every row twice).
+      string bbox_filter;
+      string exact_filter;
+      FilterSQL(StringValue::Get(filter), geometry,
+                KeywordHelper::WriteOptionallyQuoted(bbox_column), &bbox_filter,
+                &exact_filter);
+      sql = StringUtil::Format(
+          "SELECT * FROM (SELECT * REPLACE (unnest([s2_geogfromwkb(%s)]) AS %s) "
+          "FROM read_parquet(%s) WHERE %s) WHERE %s",
+          geometry, geometry, files, bbox_filter, exact_filter);
+    }
+
+    Parser parser(context.GetParserOptions());
+    parser.ParseQuery(sql);
+    auto select = unique_ptr_cast<SQLStatement, SelectStatement>(
+        std::move(parser.statements[0]));
+    return make_uniq<SubqueryRef>(std::move(select));
+  }
+
+  // The predicate is s2_intersects() against the filter (exact_filter, on the
+  // converted geometry). The latitude bounds of the filter become simple
+  // comparisons against the bbox columns that DuckDB can push into the Parquet
+  // reader; longitude is checked with s2_box_intersects() because a bbox may wrap
+  // around the antimeridian (bbox_filter).
+  static void FilterSQL(const string& filter, const string& geometry,
+                        const string& bbox, string* bbox_filter, string* exact_filter) {
+    string_t filter_str(filter);
+    GeographyDecoder decoder;
+    decoder.DecodeTag(filter_str);
+    if (decoder.tag.flags & s2geography::EncodeTag::kFlagEmpty) {
+      *bbox_filter = "false";
+      *exact_filter = "false";
+      return;
+    }
+
+    S2LatLngRect rect;
+    if (decoder.HasBounds()) {
+      decoder.DecodeTagAndBounds(filter_str);
+      rect = decoder.bounds;
+    } else {
+      rect = decoder.DecodeInPlace(filter_str).Region()->GetRectBound();
+    }
+
+    // The bbox holds the coordinates as written, which can differ slightly from
+    // the bounds of the same coordinates after a round trip through S2Point (and
+    // a cell center filter is only accurate to one leaf cell)
+    rect = rect.ExpandedByDistance(
+        S1Angle::Radians(S2::kMaxDiag.GetValue(S2CellId::kMaxLevel)));
+
+    auto field = [&](const char* name) {
+      return StringUtil::Format("struct_extract(%s, '%s')", bbox, name);
+    };
+
+    vector<string> conditions;
+    conditions.push_back(StringUtil::Format("%s <= %.17g", field("ymin"),
+                                            rect.lat_hi().degrees()));
+    conditions.push_back(StringUtil::Format("%s >= %.17g", field("ymax"),
+                                            rect.lat_lo().degrees()));
+    if (!rect.lng().is_full()) {
+      conditions.push_back(StringUtil::Format(
+          "s2_box_intersects(s2_box(%s, %s, %s, %s), s2_box(%.17g, %.17g, %.17g, %.17g))",
+          field("xmin"), field("ymin"), field("xmax"), field("ymax"),
+          rect.lng_lo().degrees(), rect.lat_lo().degrees(), rect.lng_hi().degrees(),
+          rect.lat_hi().degrees()));
+    }
+
+    static constexpr const char* kHexDigits = "0123456789abcdef";
+    string hex;
+    hex.reserve(filter.size() * 2);
+    for (unsigned char c : filter) {
+      hex += kHexDigits[c >> 4];
+      hex += kHexDigits[c & 0x0f];
+    }
+
+    *bbox_filter = StringUtil::Join(conditions, " AND ");
+    *exact_filter = StringUtil::Format(
+        "s2_intersects(%s, from_hex('%s')::GEOGRAPHY)", geometry, hex);
+  }
+};
+
 void RegisterS2GeographyFunctionsIO(DatabaseInstance& instance) {
   S2GeogFromText::Register(instance);
   S2GeogFromWKB::Register(instance);
   S2AsText::Register(instance);
   S2AsWKB::Register(instance);
   S2GeogPrepare::Register(instance);
+  S2ReadLines<S2ReadWKT>::Register(instance);
+  S2ReadLines<S2ReadWKB>::Register(instance);
+  S2ReadGeoParquet::Register(instance);
+
+#if defined(DUCKDB_HAS_ARROW_TYPE_EXTENSIONS)
+  GeoArrowWKB::Register(instance);
+#endif
 }
 
 }  // namespace duckdb_s2
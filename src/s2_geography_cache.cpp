@@ -0,0 +1,56 @@
+#include "duckdb/function/table_function.hpp"
+#include "duckdb/main/extension_util.hpp"
+
+#include "s2_geography_cache.hpp"
+
+namespace duckdb {
+
+namespace duckdb_s2 {
+
+std::atomic<int64_t> GeographyCacheStats::hits{0};
+std::atomic<int64_t> GeographyCacheStats::misses{0};
+std::atomic<int64_t> GeographyCacheStats::evictions{0};
+
+namespace {
+
+class S2CacheStatsFunctionData : public TableFunctionData {
+ public:
+  bool finished{false};
+};
+
+unique_ptr<FunctionData> S2CacheStatsBind(ClientContext& context,
+                                          TableFunctionBindInput& input,
+                                          vector<LogicalType>& return_types,
+                                          vector<string>& names) {
+  names.push_back("hits");
+  names.push_back("misses");
+  names.push_back("evictions");
+  return_types.push_back(LogicalType::BIGINT);
+  return_types.push_back(LogicalType::BIGINT);
+  return_types.push_back(LogicalType::BIGINT);
+  return make_uniq<S2CacheStatsFunctionData>();
+}
+
+void S2CacheStatsScan(ClientContext& context, TableFunctionInput& data_p,
+                      DataChunk& output) {
+  auto& data = data_p.bind_data->CastNoConst<S2CacheStatsFunctionData>();
+  if (data.finished) {
+    return;
+  }
+
+  output.SetValue(0, 0, Value::BIGINT(GeographyCacheStats::hits.load()));
+  output.SetValue(1, 0, Value::BIGINT(GeographyCacheStats::misses.load()));
+  output.SetValue(2, 0, Value::BIGINT(GeographyCacheStats::evictions.load()));
+  output.SetCardinality(1);
+  data.finished = true;
+}
+
+}  // namespace
+
+void RegisterGeographyCache(DatabaseInstance& instance) {
+  TableFunction stats_func("s2_cache_stats", {}, S2CacheStatsScan, S2CacheStatsBind);
+  ExtensionUtil::RegisterFunction(instance, stats_func);
+}
+
+}  // namespace duckdb_s2
+}  // namespace duckdb
@@ -0,0 +1,1034 @@
+#include "duckdb/catalog/catalog_entry/duck_index_entry.hpp"
+#include "duckdb/catalog/catalog_entry/duck_table_entry.hpp"
+#include "duckdb/execution/column_binding_resolver.hpp"
+#include "duckdb/execution/expression_executor.hpp"
+#include "duckdb/execution/index/bound_index.hpp"
+#include "duckdb/execution/index/fixed_size_allocator.hpp"
+#include "duckdb/execution/index/index_type.hpp"
+#include "duckdb/execution/operator/projection/physical_projection.hpp"
+#include "duckdb/execution/physical_plan_generator.hpp"
+#include "duckdb/function/table/table_scan.hpp"
+#include "duckdb/main/config.hpp"
+#include "duckdb/main/database.hpp"
+#include "duckdb/optimizer/optimizer_extension.hpp"
+#include "duckdb/parser/parsed_data/create_index_info.hpp"
+#include "duckdb/planner/expression/bound_cast_expression.hpp"
+#include "duckdb/planner/expression/bound_columnref_expression.hpp"
+#include "duckdb/planner/filter/conjunction_filter.hpp"
+#include "duckdb/planner/filter/constant_filter.hpp"
+#include "duckdb/planner/filter/struct_filter.hpp"
+#include "duckdb/planner/expression/bound_function_expression.hpp"
+#include "duckdb/planner/expression/bound_reference_expression.hpp"
+#include "duckdb/planner/logical_operator_visitor.hpp"
+#include "duckdb/planner/operator/logical_create_index.hpp"
+#include "duckdb/planner/operator/logical_extension_operator.hpp"
+#include "duckdb/planner/operator/logical_filter.hpp"
+#include "duckdb/planner/operator/logical_get.hpp"
+#include "duckdb/storage/data_table.hpp"
+#include "duckdb/storage/partial_block_manager.hpp"
+#include "duckdb/storage/table/scan_state.hpp"
+#include "duckdb/storage/table_io_manager.hpp"
+#include "duckdb/transaction/duck_transaction.hpp"
+#include "duckdb/transaction/local_storage.hpp"
+
+#include "absl/container/btree_map.h"
+#include "absl/container/btree_set.h"
+#include "s2/s2cell_id.h"
+
+#include "s2_geography_serde.hpp"
+#include "s2_index.hpp"
+#include "s2_types.hpp"
+
+namespace duckdb {
+
+namespace duckdb_s2 {
+
+namespace {
+
+//------------------------------------------------------------------------------
+// Index
+//------------------------------------------------------------------------------
+
+// A fixed-size page used to persist index entries using the index block
+// manager. Pages form a linked list starting at the root; entries with a
+// cell_id of 0 (S2CellId::None()) are non-empty geographies without a covering.
+struct S2IndexPage {
+  static constexpr idx_t kCapacity = 126;
+
+  IndexPointer next;
+  uint32_t count;
+  uint32_t has_next;
+  uint64_t cell_ids[kCapacity];
+  row_t row_ids[kCapacity];
+};
+
+// An index of GEOGRAPHY values keyed by the cells in their (already encoded)
+// covering. Like the spatial join, the index does not need to decode the
+// geography to insert or query it: a row is a candidate for a query covering if
+// any of its cells contains or is contained by a cell in the query covering.
+// Candidates must still be checked with the exact predicate.
+class S2Index : public BoundIndex {
+ public:
+  static constexpr const char* TYPE_NAME = "S2";
+
+  S2Index(const string& name, IndexConstraintType constraint_type,
+          const vector<column_t>& column_ids, TableIOManager& table_io_manager,
+          const vector<unique_ptr<Expression>>& unbound_expressions, AttachedDatabase& db,
+          const IndexStorageInfo& info = IndexStorageInfo())
+      : BoundIndex(name, TYPE_NAME, constraint_type, column_ids, table_io_manager,
+                   unbound_expressions, db) {
+    if (constraint_type != IndexConstraintType::NONE) {
+      throw NotImplementedException(
+          "S2 indexes do not support UNIQUE or PRIMARY KEY constraints");
+    }
+
+    auto& block_manager = table_io_manager.GetIndexBlockManager();
+    allocator_ = make_uniq<FixedSizeAllocator>(sizeof(S2IndexPage), block_manager);
+
+    if (info.IsValid()) {
+      root_.Set(info.root);
+      allocator_->Init(info.allocator_infos[0]);
+      ReadPages();
+    } else {
+      dirty_ = true;
+    }
+  }
+
+  static unique_ptr<BoundIndex> Create(CreateIndexInput& input) {
+    return make_uniq<S2Index>(input.name, input.constraint_type, input.column_ids,
+                              input.table_io_manager, input.unbound_expressions,
+                              input.db, input.storage_info);
+  }
+
+  // Insert geographies and their row identifiers. NULL and EMPTY geographies are
+  // never matched by a predicate and are not stored.
+  void AppendRows(Vector& geog, Vector& row_ids, idx_t count) {
+    UnifiedVectorFormat geog_format;
+    UnifiedVectorFormat row_format;
+    geog.ToUnifiedFormat(count, geog_format);
+    row_ids.ToUnifiedFormat(count, row_format);
+    auto geogs = UnifiedVectorFormat::GetData<string_t>(geog_format);
+    auto rows = UnifiedVectorFormat::GetData<row_t>(row_format);
+
+    for (idx_t i = 0; i < count; i++) {
+      auto geog_idx = geog_format.sel->get_index(i);
+      if (!geog_format.validity.RowIsValid(geog_idx)) {
+        continue;
+      }
+
+      auto row = rows[row_format.sel->get_index(i)];
+      decoder_.DecodeTagAndCovering(geogs[geog_idx]);
+      if (decoder_.tag.flags & s2geography::EncodeTag::kFlagEmpty) {
+        continue;
+      }
+
+      if (decoder_.covering.empty()) {
+        uncovered_.insert(row);
+      } else {
+        for (const S2CellId& cell_id : decoder_.covering) {
+          entries_.insert({cell_id.id(), row});
+        }
+      }
+    }
+
+    dirty_ = true;
+  }
+
+  void DeleteRows(Vector& geog, Vector& row_ids, idx_t count) {
+    UnifiedVectorFormat geog_format;
+    UnifiedVectorFormat row_format;
+    geog.ToUnifiedFormat(count, geog_format);
+    row_ids.ToUnifiedFormat(count, row_format);
+    auto geogs = UnifiedVectorFormat::GetData<string_t>(geog_format);
+    auto rows = UnifiedVectorFormat::GetData<row_t>(row_format);
+
+    for (idx_t i = 0; i < count; i++) {
+      auto geog_idx = geog_format.sel->get_index(i);
+      if (!geog_format.validity.RowIsValid(geog_idx)) {
+        continue;
+      }
+
+      auto row = rows[row_format.sel->get_index(i)];
+      decoder_.DecodeTagAndCovering(geogs[geog_idx]);
+      uncovered_.erase(row);
+      for (const S2CellId& cell_id : decoder_.covering) {
+        auto range = entries_.equal_range(cell_id.id());
+        for (auto it = range.first; it != range.second; ++it) {
+          if (it->second == row) {
+            entries_.erase(it);
+            break;
+          }
+        }
+      }
+    }
+
+    dirty_ = true;
+  }
+
+  // Collect the (sorted, unique) row identifiers whose covering intersects
+  // the query covering
+  void Query(const vector<S2CellId>& covering, vector<row_t>& result) {
+    IndexLock lock;
+    InitializeLock(lock);
+
+    result.clear();
+    for (const S2CellId& cell_id : covering) {
+      // Cells contained by this cell
+      auto end = entries_.upper_bound(cell_id.range_max().id());
+      for (auto it = entries_.lower_bound(cell_id.range_min().id()); it != end; ++it) {
+        result.push_back(it->second);
+      }
+
+      // Cells containing this cell
+      for (int level = cell_id.level() - 1; level >= 0; level--) {
+        auto range = entries_.equal_range(cell_id.parent(level).id());
+        for (auto it = range.first; it != range.second; ++it) {
+          result.push_back(it->second);
+        }
+      }
+    }
+
+    result.insert(result.end(), uncovered_.begin(), uncovered_.end());
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+  }
+
+  ErrorData Append(IndexLock& lock, DataChunk& entries, Vector& row_ids) override {
+    AppendRows(entries.data[0], row_ids, entries.size());
+    return ErrorData();
+  }
+
+  ErrorData Insert(IndexLock& lock, DataChunk& data, Vector& row_ids) override {
+    AppendRows(data.data[0], row_ids, data.size());
+    return ErrorData();
+  }
+
+  void Delete(IndexLock& lock, DataChunk& entries, Vector& row_ids) override {
+    DeleteRows(entries.data[0], row_ids, entries.size());
+  }
+
+  void CommitDrop(IndexLock& lock) override {
+    entries_.clear();
+    uncovered_.clear();
+    allocator_->Reset();
+    dirty_ = true;
+  }
+
+  bool MergeIndexes(IndexLock& state, BoundIndex& other_index) override {
+    auto& other = other_index.Cast<S2Index>();
+    entries_.insert(other.entries_.begin(), other.entries_.end());
+    uncovered_.insert(other.uncovered_.begin(), other.uncovered_.end());
+    dirty_ = true;
+    return true;
+  }
+
+  void Vacuum(IndexLock& state) override {}
+
+  idx_t GetInMemorySize(IndexLock& state) override {
+    return allocator_->GetInMemorySize() +
+           entries_.size() * (sizeof(uint64_t) + sizeof(row_t)) +
+           uncovered_.size() * sizeof(row_t);
+  }
+
+  void CheckConstraintsForChunk(DataChunk& input,
+                                ConflictManager& conflict_manager) override {}
+
+  string VerifyAndToString(IndexLock& state, const bool only_verify) override {
+    if (only_verify) {
+      return "";
+    }
+
+    return StringUtil::Format("S2 index with %d cell entries and %d uncovered rows",
+                              entries_.size(), uncovered_.size());
+  }
+
+  string GetConstraintViolationMessage(VerifyExistenceType verify_type,
+                                       idx_t failed_index, DataChunk& input) override {
+    return "Constraint violation in S2 index";
+  }
+
+  IndexStorageInfo GetStorageInfo(const bool get_buffers) override {
+    // The in-memory btree is the source of truth; pages are only rewritten
+    // when something has changed since they were last written or read.
+    if (dirty_) {
+      WritePages();
+      dirty_ = false;
+    }
+
+    IndexStorageInfo info;
+    info.name = GetIndexName();
+    info.root = root_.Get();
+
+    if (!get_buffers) {
+      auto& block_manager = table_io_manager.GetIndexBlockManager();
+      PartialBlockManager partial_block_manager(block_manager,
+                                                PartialBlockType::FULL_CHECKPOINT);
+      allocator_->SerializeBuffers(partial_block_manager);
+      partial_block_manager.FlushPartialBlocks();
+    } else {
+      info.buffers.push_back(allocator_->InitSerializationToWAL());
+    }
+
+    info.allocator_infos.push_back(allocator_->GetInfo());
+    return info;
+  }
+
+ private:
+  absl::btree_multimap<uint64_t, row_t> entries_;
+  absl::btree_set<row_t> uncovered_;
+  GeographyDecoder decoder_;
+
+  unique_ptr<FixedSizeAllocator> allocator_;
+  IndexPointer root_;
+  bool dirty_{false};
+
+  S2IndexPage* NewPage(IndexPointer& ptr) {
+    ptr = allocator_->New();
+    auto page = allocator_->Get<S2IndexPage>(ptr);
+    page->count = 0;
+    page->has_next = 0;
+    return page;
+  }
+
+  void WritePages() {
+    allocator_->Reset();
+
+    IndexPointer page_ptr;
+    auto page = NewPage(page_ptr);
+    root_ = page_ptr;
+
+    auto append = [&](uint64_t cell_id, row_t row) {
+      if (page->count == S2IndexPage::kCapacity) {
+        IndexPointer next_ptr;
+        auto next = NewPage(next_ptr);
+        page = allocator_->Get<S2IndexPage>(page_ptr);
+        page->next = next_ptr;
+        page->has_next = 1;
+        page_ptr = next_ptr;
+        page = next;
+      }
+
+      page->cell_ids[page->count] = cell_id;
+      page->row_ids[page->count] = row;
+      page->count++;
+    };
+
+    for (const auto& entry : entries_) {
+      append(entry.first, entry.second);
+    }
+
+    for (row_t row : uncovered_) {
+      append(S2CellId::None().id(), row);
+    }
+  }
+
+  void ReadPages() {
+    IndexPointer page_ptr = root_;
+    while (true) {
+      auto page = allocator_->Get<S2IndexPage>(page_ptr, false);
+      for (uint32_t i = 0; i < page->count; i++) {
+        if (page->cell_ids[i] == S2CellId::None().id()) {
+          uncovered_.insert(page->row_ids[i]);
+        } else {
+          entries_.insert({page->cell_ids[i], page->row_ids[i]});
+        }
+      }
+
+      if (!page->has_next) {
+        break;
+      }
+
+      page_ptr = page->next;
+    }
+  }
+};
+
+//------------------------------------------------------------------------------
+// CREATE INDEX ... USING S2
+//------------------------------------------------------------------------------
+
+class S2IndexCreateGlobalState : public GlobalSinkState {
+ public:
+  unique_ptr<S2Index> index;
+};
+
+class PhysicalCreateS2Index : public PhysicalOperator {
+ public:
+  PhysicalCreateS2Index(LogicalOperator& op, TableCatalogEntry& table_p,
+                        const vector<column_t>& column_ids,
+                        unique_ptr<CreateIndexInfo> info_p,
+                        vector<unique_ptr<Expression>> unbound_expressions_p,
+                        idx_t estimated_cardinality)
+      : PhysicalOperator(PhysicalOperatorType::EXTENSION, op.types,
+                         estimated_cardinality),
+        table(table_p.Cast<DuckTableEntry>()),
+        info(std::move(info_p)),
+        unbound_expressions(std::move(unbound_expressions_p)) {
+    for (auto& column_id : column_ids) {
+      storage_ids.push_back(
+          table.GetColumns().LogicalToPhysical(LogicalIndex(column_id)).index);
+    }
+  }
+
+  DuckTableEntry& table;
+  vector<column_t> storage_ids;
+  unique_ptr<CreateIndexInfo> info;
+  vector<unique_ptr<Expression>> unbound_expressions;
+
+  string GetName() const override { return "CREATE_S2_INDEX"; }
+
+  // Source interface (no output)
+  SourceResultType GetData(ExecutionContext& context, DataChunk& chunk,
+                           OperatorSourceInput& input) const override {
+    return SourceResultType::FINISHED;
+  }
+
+  bool IsSource() const override { return true; }
+
+  // Sink interface: the input is the geography column followed by the row id
+  unique_ptr<GlobalSinkState> GetGlobalSinkState(ClientContext& context) const override {
+    auto state = make_uniq<S2IndexCreateGlobalState>();
+    auto& storage = table.GetStorage();
+    state->index = make_uniq<S2Index>(info->index_name, info->constraint_type,
+                                      storage_ids, TableIOManager::Get(storage),
+                                      unbound_expressions, storage.db);
+    return std::move(state);
+  }
+
+  SinkResultType Sink(ExecutionContext& context, DataChunk& chunk,
+                      OperatorSinkInput& input) const override {
+    auto& state = input.global_state.Cast<S2IndexCreateGlobalState>();
+    state.index->AppendRows(chunk.data[0], chunk.data[1], chunk.size());
+    return SinkResultType::NEED_MORE_INPUT;
+  }
+
+  SinkFinalizeType Finalize(Pipeline& pipeline, Event& event, ClientContext& context,
+                            OperatorSinkFinalizeInput& input) const override {
+    auto& state = input.global_state.Cast<S2IndexCreateGlobalState>();
+
+    auto& storage = table.GetStorage();
+    if (!storage.IsRoot()) {
+      throw TransactionException("Cannot create index on non-root transaction");
+    }
+
+    auto& schema = table.schema;
+    info->column_ids = storage_ids;
+    auto index_entry =
+        schema.CreateIndex(schema.GetCatalogTransaction(context), *info, table).get();
+    if (!index_entry) {
+      D_ASSERT(info->on_conflict == OnCreateConflict::IGNORE_ON_CONFLICT);
+      return SinkFinalizeType::READY;
+    }
+
+    IndexLock lock;
+    state.index->InitializeLock(lock);
+    auto& duck_index = index_entry->Cast<DuckIndexEntry>();
+    duck_index.initial_index_size = state.index->GetInMemorySize(lock);
+    lock.index_lock.unlock();
+
+    storage.AddIndex(std::move(state.index));
+    return SinkFinalizeType::READY;
+  }
+
+  bool IsSink() const override { return true; }
+
+  bool ParallelSink() const override { return false; }
+};
+
+class LogicalCreateS2Index : public LogicalExtensionOperator {
+ public:
+  LogicalCreateS2Index(unique_ptr<CreateIndexInfo> info_p,
+                       vector<unique_ptr<Expression>> expressions_p,
+                       vector<unique_ptr<Expression>> unbound_expressions_p,
+                       TableCatalogEntry& table_p)
+      : info(std::move(info_p)),
+        unbound_expressions(std::move(unbound_expressions_p)),
+        table(table_p) {
+    expressions = std::move(expressions_p);
+  }
+
+  unique_ptr<CreateIndexInfo> info;
+  vector<unique_ptr<Expression>> unbound_expressions;
+  TableCatalogEntry& table;
+
+  string GetExtensionName() const override { return "s2_create_index"; }
+
+  // Index expressions are bound against the columns of the table (as they
+  // are for LogicalCreateIndex)
+  void ResolveColumnBindings(ColumnBindingResolver& res,
+                             vector<ColumnBinding>& bindings) override {
+    bindings = LogicalOperator::GenerateColumnBindings(
+        0, table.GetColumns().LogicalColumnCount());
+    LogicalOperatorVisitor::EnumerateExpressions(
+        *this, [&](unique_ptr<Expression>* child) { res.VisitExpression(child); });
+  }
+
+  unique_ptr<PhysicalOperator> CreatePlan(ClientContext& context,
+                                          PhysicalPlanGenerator& generator) override {
+    if (expressions.size() != 1 || expressions[0]->return_type != Types::GEOGRAPHY()) {
+      throw BinderException("S2 indexes can only be created over a single GEOGRAPHY");
+    }
+
+    auto table_scan = generator.CreatePlan(std::move(children[0]));
+
+    // Project the geography expression and the row id
+    vector<LogicalType> projection_types{expressions[0]->return_type,
+                                         LogicalType::ROW_TYPE};
+    vector<unique_ptr<Expression>> select_list;
+    select_list.push_back(std::move(expressions[0]));
+    select_list.push_back(make_uniq<BoundReferenceExpression>(
+        LogicalType::ROW_TYPE, info->scan_types.size() - 1));
+    auto projection = make_uniq<PhysicalProjection>(
+        std::move(projection_types), std::move(select_list), estimated_cardinality);
+    projection->children.push_back(std::move(table_scan));
+
+    auto column_ids = info->column_ids;
+    auto create_index = make_uniq<PhysicalCreateS2Index>(
+        *this, table, column_ids, std::move(info), std::move(unbound_expressions),
+        estimated_cardinality);
+    create_index->children.push_back(std::move(projection));
+    return std::move(create_index);
+  }
+
+ protected:
+  void ResolveTypes() override { types.emplace_back(LogicalType::BIGINT); }
+};
+
+//------------------------------------------------------------------------------
+// Index scan
+//------------------------------------------------------------------------------
+
+class S2IndexScanBindData : public TableScanBindData {
+ public:
+  S2IndexScanBindData(DuckTableEntry& table, S2Index& index_p,
+                      vector<S2CellId> covering_p)
+      : TableScanBindData(table), index(index_p), covering(std::move(covering_p)) {}
+
+  S2Index& index;
+  vector<S2CellId> covering;
+
+  unique_ptr<FunctionData> Copy() const override {
+    return make_uniq<S2IndexScanBindData>(table, index, covering);
+  }
+
+  bool Equals(const FunctionData& other_p) const override {
+    auto& other = other_p.Cast<S2IndexScanBindData>();
+    return &other.table == &table && &other.index == &index &&
+           other.covering == covering;
+  }
+};
+
+class S2IndexScanGlobalState : public GlobalTableFunctionState {
+ public:
+  ColumnFetchState fetch_state;
+  vector<column_t> column_ids;
+  vector<row_t> row_ids;
+  idx_t offset{0};
+
+  // Rows appended by this transaction (which are not in the index yet)
+  TableScanState local_scan;
+};
+
+struct S2IndexScan {
+  static unique_ptr<GlobalTableFunctionState> Init(ClientContext& context,
+                                                   TableFunctionInitInput& input) {
+    auto& bind_data = input.bind_data->Cast<S2IndexScanBindData>();
+    auto result = make_uniq<S2IndexScanGlobalState>();
+
+    for (auto& column_id : input.column_ids) {
+      if (column_id == COLUMN_IDENTIFIER_ROW_ID) {
+        result->column_ids.push_back(column_id);
+      } else {
+        result->column_ids.push_back(
+            bind_data.table.GetColumn(LogicalIndex(column_id)).StorageOid());
+      }
+    }
+
+    bind_data.index.Query(bind_data.covering, result->row_ids);
+
+    auto& transaction = DuckTransaction::Get(context, bind_data.table.catalog);
+    auto& local_storage = LocalStorage::Get(transaction);
+    result->local_scan.Initialize(result->column_ids);
+    local_storage.InitializeScan(bind_data.table.GetStorage(),
+                                 result->local_scan.local_state, nullptr);
+    return std::move(result);
+  }
+
+  static void Execute(ClientContext& context, TableFunctionInput& data_p,
+                      DataChunk& output) {
+    auto& bind_data = data_p.bind_data->Cast<S2IndexScanBindData>();
+    auto& state = data_p.global_state->Cast<S2IndexScanGlobalState>();
+    auto& transaction = DuckTransaction::Get(context, bind_data.table.catalog);
+    auto& storage = bind_data.table.GetStorage();
+
+    // Rows that are not visible to this transaction are skipped by Fetch(), so
+    // keep fetching until we have output or have run out of candidates
+    while (output.size() == 0 && state.offset < state.row_ids.size()) {
+      idx_t count =
+          MinValue<idx_t>(STANDARD_VECTOR_SIZE, state.row_ids.size() - state.offset);
+      Vector row_ids(LogicalType::ROW_TYPE,
+                     reinterpret_cast<data_ptr_t>(state.row_ids.data() + state.offset));
+      state.offset += count;
+
+      output.Reset();
+      storage.Fetch(transaction, output, state.column_ids, row_ids, count,
+                    state.fetch_state);
+    }
+
+    // Rows appended by this transaction are only added to the index when it
+    // commits, so they are scanned in full after the index candidates (the
+    // filter above this scan takes care of the rest)
+    if (output.size() == 0) {
+      auto& local_storage = LocalStorage::Get(transaction);
+      local_storage.Scan(state.local_scan.local_state, state.local_scan.GetColumnIds(),
+                         output);
+    }
+  }
+
+  static TableFunction GetFunction() {
+    TableFunction func("s2_index_scan", {}, Execute);
+    func.init_global = Init;
+    func.projection_pushdown = true;
+    func.filter_pushdown = false;
+    return func;
+  }
+};
+
+//------------------------------------------------------------------------------
+// Optimizer
+//------------------------------------------------------------------------------
+
+// Predicates for which intersecting coverings are a necessary condition
+bool IsIndexPredicate(const string& name) {
+  return name == "s2_intersects" || name == "s2_contains" || name == "s2_equals" ||
+         name == "s2_mayintersect";
+}
+
+// Check for predicate(column, constant) or predicate(constant, column) where
+// column is a column of get, returning the (logical) column index and the
+// covering of the constant.
+bool MatchIndexPredicate(ClientContext& context, LogicalGet& get, Expression& expr,
+                         column_t& column_id, vector<S2CellId>& covering) {
+  if (expr.GetExpressionClass() != ExpressionClass::BOUND_FUNCTION) {
+    return false;
+  }
+
+  auto& func = expr.Cast<BoundFunctionExpression>();
+  if (!IsIndexPredicate(func.function.name) || func.children.size() != 2) {
+    return false;
+  }
+
+  for (idx_t i = 0; i < 2; i++) {
+    auto& column = *func.children[i];
+    auto& constant = *func.children[1 - i];
+    if (column.GetExpressionClass() != ExpressionClass::BOUND_COLUMN_REF ||
+        !constant.IsFoldable()) {
+      continue;
+    }
+
+    auto& colref = column.Cast<BoundColumnRefExpression>();
+    if (colref.depth != 0 || colref.binding.table_index != get.table_index) {
+      continue;
+    }
+
+    column_id = get.column_ids[colref.binding.column_index];
+    if (column_id == COLUMN_IDENTIFIER_ROW_ID) {
+      continue;
+    }
+
+    Value value;
+    if (!ExpressionExecutor::TryEvaluateScalar(context, constant, value) ||
+        value.IsNull()) {
+      return false;
+    }
+
+    auto str = StringValue::Get(value);
+    GeographyDecoder decoder;
+    decoder.DecodeTagAndCovering(string_t(str));
+
+    // A non-empty geography without a covering can't be used to look up rows
+    if (decoder.covering.empty() &&
+        !(decoder.tag.flags & s2geography::EncodeTag::kFlagEmpty)) {
+      return false;
+    }
+
+    covering = std::move(decoder.covering);
+    return true;
+  }
+
+  return false;
+}
+
+void TryRewriteIndexScan(ClientContext& context, unique_ptr<LogicalOperator>& op) {
+  for (auto& child : op->children) {
+    TryRewriteIndexScan(context, child);
+  }
+
+  if (op->type != LogicalOperatorType::LOGICAL_FILTER ||
+      op->children[0]->type != LogicalOperatorType::LOGICAL_GET) {
+    return;
+  }
+
+  auto& filter = op->Cast<LogicalFilter>();
+  auto& get = filter.children[0]->Cast<LogicalGet>();
+  if (get.function.name != "seq_scan" || !get.bind_data) {
+    return;
+  }
+
+  // Rows fetched by row id would not have pushed-down table filters applied
+  if (!get.table_filters.filters.empty()) {
+    return;
+  }
+
+  auto table = get.GetTable();
+  if (!table || !table->IsDuckTable()) {
+    return;
+  }
+
+  auto& duck_table = table->Cast<DuckTableEntry>();
+  auto& storage = duck_table.GetStorage();
+  storage.info->InitializeIndexes(context, S2Index::TYPE_NAME);
+
+  for (auto& expr : filter.expressions) {
+    column_t column_id;
+    vector<S2CellId> covering;
+    if (!MatchIndexPredicate(context, get, *expr, column_id, covering)) {
+      continue;
+    }
+
+    auto storage_id = duck_table.GetColumns().LogicalToPhysical(LogicalIndex(column_id));
+    optional_ptr<S2Index> index;
+    storage.info->indexes.Scan([&](Index& candidate) {
+      if (candidate.GetIndexType() == S2Index::TYPE_NAME && candidate.IsBound() &&
+          candidate.column_ids.size() == 1 &&
+          candidate.column_ids[0] == storage_id.index) {
+        index = &candidate.Cast<S2Index>();
+        return true;
+      }
+
+      return false;
+    });
+
+    if (!index) {
+      continue;
+    }
+
+    // The filter stays in place: the index only produces candidates
+    get.function = S2IndexScan::GetFunction();
+    get.bind_data =
+        make_uniq<S2IndexScanBindData>(duck_table, *index, std::move(covering));
+    return;
+  }
+}
+
+void TryRewriteCreateIndex(unique_ptr<LogicalOperator>& plan) {
+  if (plan->type != LogicalOperatorType::LOGICAL_CREATE_INDEX) {
+    return;
+  }
+
+  auto& create_index = plan->Cast<LogicalCreateIndex>();
+  if (!StringUtil::CIEquals(create_index.info->index_type, S2Index::TYPE_NAME)) {
+    return;
+  }
+
+  create_index.info->index_type = S2Index::TYPE_NAME;
+  auto op = make_uniq<LogicalCreateS2Index>(
+      std::move(create_index.info), std::move(create_index.expressions),
+      std::move(create_index.unbound_expressions), create_index.table);
+  op->children = std::move(create_index.children);
+  plan = std::move(op);
+}
+
+//------------------------------------------------------------------------------
+// Cell range pushdown
+//------------------------------------------------------------------------------
+
+// Above this many ranges the filter is probably more expensive than it is worth
+static constexpr idx_t kMaxCellRangeFilters = 64;
+
+// The values a cell column can take for a predicate to be true: any cell id
+// within one of the ranges (i.e., descendants of a cell) or exactly one of the
+// cells (i.e., ancestors of a cell).
+struct CellRanges {
+  vector<std::pair<uint64_t, uint64_t>> ranges;
+  vector<uint64_t> cells;
+
+  void AddDescendants(S2CellId cell) {
+    ranges.push_back({cell.range_min().id(), cell.range_max().id()});
+  }
+
+  void AddAncestors(S2CellId cell) {
+    for (int level = 0; level <= cell.level(); level++) {
+      cells.push_back(cell.parent(level).id());
+    }
+  }
+
+  // Sort and merge ranges and remove cells that are already within a range
+  void Normalize() {
+    std::sort(ranges.begin(), ranges.end());
+    vector<std::pair<uint64_t, uint64_t>> merged;
+    for (const auto& range : ranges) {
+      // Leaf cell ids are odd, so the next leaf after range_max is range_max + 2
+      if (!merged.empty() && range.first <= merged.back().second + 2) {
+        merged.back().second = MaxValue(merged.back().second, range.second);
+      } else {
+        merged.push_back(range);
+      }
+    }
+    ranges = std::move(merged);
+
+    std::sort(cells.begin(), cells.end());
+    cells.erase(std::unique(cells.begin(), cells.end()), cells.end());
+    cells.erase(std::remove_if(cells.begin(), cells.end(),
+                               [&](uint64_t cell) {
+                                 for (const auto& range : ranges) {
+                                   if (cell >= range.first && cell <= range.second) {
+                                     return true;
+                                   }
+                                 }
+                                 return false;
+                               }),
+                cells.end());
+  }
+
+  unique_ptr<TableFilter> ToTableFilter() const {
+    auto result = make_uniq<ConjunctionOrFilter>();
+    for (const auto& range : ranges) {
+      auto range_filter = make_uniq<ConjunctionAndFilter>();
+      range_filter->child_filters.push_back(make_uniq<ConstantFilter>(
+          ExpressionType::COMPARE_GREATERTHANOREQUALTO, Value::UBIGINT(range.first)));
+      range_filter->child_filters.push_back(make_uniq<ConstantFilter>(
+          ExpressionType::COMPARE_LESSTHANOREQUALTO, Value::UBIGINT(range.second)));
+      result->child_filters.push_back(std::move(range_filter));
+    }
+
+    for (uint64_t cell : cells) {
+      result->child_filters.push_back(
+          make_uniq<ConstantFilter>(ExpressionType::COMPARE_EQUAL, Value::UBIGINT(cell)));
+    }
+
+    if (result->child_filters.size() == 1) {
+      return std::move(result->child_filters[0]);
+    }
+
+    return std::move(result);
+  }
+};
+
+// Returns the S2_CELL or S2_CELL_CENTER column of get referred to by expr (possibly
+// cast to another cell type or to GEOGRAPHY), or nullptr if there isn't one
+optional_ptr<BoundColumnRefExpression> GetCellColumn(LogicalGet& get, Expression& expr) {
+  optional_ptr<Expression> current = &expr;
+  while (current->GetExpressionClass() == ExpressionClass::BOUND_CAST) {
+    current = current->Cast<BoundCastExpression>().child.get();
+  }
+
+  if (current->GetExpressionClass() != ExpressionClass::BOUND_COLUMN_REF ||
+      (current->return_type != Types::S2_CELL() &&
+       current->return_type != Types::S2_CELL_CENTER())) {
+    return nullptr;
+  }
+
+  auto& colref = current->Cast<BoundColumnRefExpression>();
+  if (colref.depth != 0 || colref.binding.table_index != get.table_index) {
+    return nullptr;
+  }
+
+  return &colref;
+}
+
+// Check for a predicate between a cell column of get and a constant (a cell for
+// s2_cell_contains() or s2_cell_intersects(), or a geography with a covering for
+// the index predicates) and compute the cell ids that column may contain.
+bool MatchCellPredicate(ClientContext& context, LogicalGet& get, Expression& expr,
+                        column_t& column_id, CellRanges& out) {
+  if (expr.GetExpressionClass() != ExpressionClass::BOUND_FUNCTION) {
+    return false;
+  }
+
+  auto& func = expr.Cast<BoundFunctionExpression>();
+  const string& name = func.function.name;
+  bool is_cell_contains = name == "s2_cell_contains";
+  bool is_cell_intersects = name == "s2_cell_intersects";
+  if ((!is_cell_contains && !is_cell_intersects && !IsIndexPredicate(name)) ||
+      func.children.size() != 2) {
+    return false;
+  }
+
+  for (idx_t i = 0; i < 2; i++) {
+    auto colref = GetCellColumn(get, *func.children[i]);
+    auto& constant = *func.children[1 - i];
+    if (!colref || !constant.IsFoldable()) {
+      continue;
+    }
+
+    column_id = get.column_ids[colref->binding.column_index];
+    if (column_id == COLUMN_IDENTIFIER_ROW_ID) {
+      continue;
+    }
+
+    Value value;
+    if (!ExpressionExecutor::TryEvaluateScalar(context, constant, value) ||
+        value.IsNull()) {
+      return false;
+    }
+
+    if (is_cell_contains || is_cell_intersects) {
+      S2CellId cell(value.GetValue<uint64_t>());
+      if (!cell.is_valid()) {
+        return false;
+      }
+
+      // s2_cell_contains(constant, column) matches descendants of the constant;
+      // s2_cell_contains(column, constant) matches its ancestors
+      if (is_cell_intersects || i == 1) {
+        out.AddDescendants(cell);
+      }
+
+      if (is_cell_intersects || i == 0) {
+        out.AddAncestors(cell);
+      }
+    } else {
+      auto str = StringValue::Get(value);
+      GeographyDecoder decoder;
+      decoder.DecodeTagAndCovering(string_t(str));
+      if (decoder.covering.empty()) {
+        return false;
+      }
+
+      // A cell that intersects the covering is either within one of its cells
+      // or contains one of them (a cell center can only be the former)
+      bool is_cell_center = colref->return_type == Types::S2_CELL_CENTER();
+      for (const S2CellId& cell : decoder.covering) {
+        out.AddDescendants(cell);
+        if (!is_cell_center) {
+          out.AddAncestors(cell);
+        }
+      }
+    }
+
+    out.Normalize();
+    return out.ranges.size() + out.cells.size() <= kMaxCellRangeFilters;
+  }
+
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// Box pushdown
+//------------------------------------------------------------------------------
+
+// Check for s2_box_intersects(column, constant) or s2_box_intersects(constant,
+// column) where column is an S2_BOX column of get. The latitude range of the
+// constant becomes filters on the ymin and ymax fields that can be checked against
+// the statistics of each row group; longitude can't be filtered this way because
+// either box may wrap around the antimeridian.
+bool MatchBoxPredicate(ClientContext& context, LogicalGet& get, Expression& expr,
+                       column_t& column_id, vector<unique_ptr<TableFilter>>& filters) {
+  if (expr.GetExpressionClass() != ExpressionClass::BOUND_FUNCTION) {
+    return false;
+  }
+
+  auto& func = expr.Cast<BoundFunctionExpression>();
+  if (func.function.name != "s2_box_intersects" || func.children.size() != 2) {
+    return false;
+  }
+
+  for (idx_t i = 0; i < 2; i++) {
+    auto& column = *func.children[i];
+    auto& constant = *func.children[1 - i];
+    if (column.GetExpressionClass() != ExpressionClass::BOUND_COLUMN_REF ||
+        column.return_type != Types::S2_BOX() || !constant.IsFoldable()) {
+      continue;
+    }
+
+    auto& colref = column.Cast<BoundColumnRefExpression>();
+    if (colref.depth != 0 || colref.binding.table_index != get.table_index) {
+      continue;
+    }
+
+    column_id = get.column_ids[colref.binding.column_index];
+    if (column_id == COLUMN_IDENTIFIER_ROW_ID) {
+      continue;
+    }
+
+    Value value;
+    if (!ExpressionExecutor::TryEvaluateScalar(context, constant, value) ||
+        value.IsNull()) {
+      return false;
+    }
+
+    // The children of an S2_BOX are xmin, ymin, xmax, ymax
+    auto& box = StructValue::GetChildren(value);
+    double ymin = box[1].GetValue<double>();
+    double ymax = box[3].GetValue<double>();
+    filters.push_back(make_uniq<StructFilter>(
+        1, "ymin",
+        make_uniq<ConstantFilter>(ExpressionType::COMPARE_LESSTHANOREQUALTO,
+                                  Value::DOUBLE(ymax))));
+    filters.push_back(make_uniq<StructFilter>(
+        3, "ymax",
+        make_uniq<ConstantFilter>(ExpressionType::COMPARE_GREATERTHANOREQUALTO,
+                                  Value::DOUBLE(ymin))));
+    return true;
+  }
+
+  return false;
+}
+
+// Push filters on cell and box columns into the scan such that zone maps (or
+// Parquet row group statistics) can be used to skip data. The original filter
+// stays in place.
+void TryPushSpatialFilters(ClientContext& context, unique_ptr<LogicalOperator>& op) {
+  for (auto& child : op->children) {
+    TryPushSpatialFilters(context, child);
+  }
+
+  if (op->type != LogicalOperatorType::LOGICAL_FILTER ||
+      op->children[0]->type != LogicalOperatorType::LOGICAL_GET) {
+    return;
+  }
+
+  auto& filter = op->Cast<LogicalFilter>();
+  auto& get = filter.children[0]->Cast<LogicalGet>();
+  if (!get.function.filter_pushdown) {
+    return;
+  }
+
+  for (auto& expr : filter.expressions) {
+    column_t column_id;
+    CellRanges ranges;
+    vector<unique_ptr<TableFilter>> box_filters;
+    if (MatchCellPredicate(context, get, *expr, column_id, ranges)) {
+      get.table_filters.PushFilter(column_id, ranges.ToTableFilter());
+    } else if (MatchBoxPredicate(context, get, *expr, column_id, box_filters)) {
+      for (auto& box_filter : box_filters) {
+        get.table_filters.PushFilter(column_id, std::move(box_filter));
+      }
+    }
+  }
+}
+
+void S2IndexOptimize(OptimizerExtensionInput& input, unique_ptr<LogicalOperator>& plan) {
+  TryRewriteCreateIndex(plan);
+  TryRewriteIndexScan(input.context, plan);
+  TryPushSpatialFilters(input.context, plan);
+}
+
+}  // namespace
+
+void RegisterS2Index(DatabaseInstance& instance) {
+  auto& config = DBConfig::GetConfig(instance);
+
+  IndexType index_type;
+  index_type.name = S2Index::TYPE_NAME;
+  index_type.create_instance = S2Index::Create;
+  config.GetIndexTypes().RegisterIndexType(index_type);
+
+  OptimizerExtension optimizer;
+  optimizer.optimize_function = S2IndexOptimize;
+  config.optimizer_extensions.push_back(std::move(optimizer));
+}
+
+}  // namespace duckdb_s2
+}  // namespace duckdb
@@ -0,0 +1,232 @@
+
+#include <algorithm>
+#include <cmath>
+
+#include "duckdb/common/assert.hpp"
+#include "duckdb/common/typedefs.hpp"
+
+#include "s2/s2cell_id.h"
+#include "s2/s2coords.h"
+#include "s2/s2latlng.h"
+
+#include "s2_cell_ops.hpp"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define S2_LNGLAT_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+// This file is compiled with -ffp-contract=off (see CMakeLists.txt): every
+// kernel here must produce exactly the same cell ids as
+// S2CellId(S2LatLng::FromDegrees(lat, lng).ToPoint()), which is only possible if
+// the compiler is not allowed to fuse multiplies and adds differently in the
+// vectorized and scalar versions.
+
+namespace duckdb {
+
+namespace duckdb_s2 {
+
+namespace {
+
+// Number of points converted per pass. Each pass projects lng/lat to xyz (scalar,
+// because trigonometry from libm can't be vectorized without changing results),
+// computes face/s/t for the whole block (vectorized when possible), and then
+// interleaves the i/j bits into cell ids (scalar).
+constexpr idx_t kBlockSize = 256;
+
+// Computes face, s, and t for count points exactly like S2::XYZtoFaceUV()
+// followed by S2::UVtoST().
+using FaceSTKernel = void (*)(const double* x, const double* y, const double* z,
+                              idx_t count, int* face, double* s, double* t);
+
+void FaceSTScalar(const double* x, const double* y, const double* z, idx_t count,
+                  int* face, double* s, double* t) {
+  for (idx_t i = 0; i < count; i++) {
+    double u, v;
+    face[i] = S2::XYZtoFaceUV(S2Point(x[i], y[i], z[i]), &u, &v);
+    s[i] = S2::UVtoST(u);
+    t[i] = S2::UVtoST(v);
+  }
+}
+
+#ifdef S2_LNGLAT_KERNELS_X86
+
+// The vectorized kernels below mirror the scalar version operation for
+// operation. The face is the largest absolute component (ties resolved in the
+// same order as Vector3::LargestAbsComponent()) plus 3 if that component is
+// negative. The u and v numerators for faces 0, 1, and 2 are (y, z), (-x, z), and
+// (-x, -y); faces 3, 4, and 5 use the same numerators swapped. Both are divided
+// by the major component and UVtoST() is applied as
+// 0.5 * sqrt(1 + 3 * |u|), subtracted from 1 if u is negative.
+
+__attribute__((target("avx2"))) void FaceSTAvx2(const double* x, const double* y,
+                                                const double* z, idx_t count,
+                                                int* face, double* s, double* t) {
+  const __m256d sign_bit = _mm256_set1_pd(-0.0);
+  const __m256d zero = _mm256_setzero_pd();
+  const __m256d half = _mm256_set1_pd(0.5);
+  const __m256d one = _mm256_set1_pd(1);
+  const __m256d three = _mm256_set1_pd(3);
+
+  idx_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m256d px = _mm256_loadu_pd(x + i);
+    __m256d py = _mm256_loadu_pd(y + i);
+    __m256d pz = _mm256_loadu_pd(z + i);
+    __m256d ax = _mm256_andnot_pd(sign_bit, px);
+    __m256d ay = _mm256_andnot_pd(sign_bit, py);
+    __m256d az = _mm256_andnot_pd(sign_bit, pz);
+
+    __m256d x_gt_y = _mm256_cmp_pd(ax, ay, _CMP_GT_OQ);
+    __m256d is_x = _mm256_and_pd(x_gt_y, _mm256_cmp_pd(ax, az, _CMP_GT_OQ));
+    __m256d is_y = _mm256_andnot_pd(x_gt_y, _mm256_cmp_pd(ay, az, _CMP_GT_OQ));
+
+    __m256d major = _mm256_blendv_pd(_mm256_blendv_pd(pz, py, is_y), px, is_x);
+    __m256d neg_x = _mm256_xor_pd(px, sign_bit);
+    __m256d a = _mm256_blendv_pd(neg_x, py, is_x);
+    __m256d b = _mm256_blendv_pd(_mm256_xor_pd(py, sign_bit), pz,
+                                 _mm256_or_pd(is_x, is_y));
+
+    __m256d neg = _mm256_cmp_pd(major, zero, _CMP_LT_OQ);
+    __m256d u = _mm256_div_pd(_mm256_blendv_pd(a, b, neg), major);
+    __m256d v = _mm256_div_pd(_mm256_blendv_pd(b, a, neg), major);
+
+    __m256d ru = _mm256_mul_pd(
+        half, _mm256_sqrt_pd(_mm256_add_pd(
+                  one, _mm256_mul_pd(three, _mm256_andnot_pd(sign_bit, u)))));
+    __m256d rv = _mm256_mul_pd(
+        half, _mm256_sqrt_pd(_mm256_add_pd(
+                  one, _mm256_mul_pd(three, _mm256_andnot_pd(sign_bit, v)))));
+    _mm256_storeu_pd(s + i, _mm256_blendv_pd(_mm256_sub_pd(one, ru), ru,
+                                             _mm256_cmp_pd(u, zero, _CMP_GE_OQ)));
+    _mm256_storeu_pd(t + i, _mm256_blendv_pd(_mm256_sub_pd(one, rv), rv,
+                                             _mm256_cmp_pd(v, zero, _CMP_GE_OQ)));
+
+    int x_bits = _mm256_movemask_pd(is_x);
+    int y_bits = _mm256_movemask_pd(is_y);
+    int neg_bits = _mm256_movemask_pd(neg);
+    for (int lane = 0; lane < 4; lane++) {
+      int f = (x_bits >> lane & 1) ? 0 : ((y_bits >> lane & 1) ? 1 : 2);
+      face[i + lane] = f + 3 * (neg_bits >> lane & 1);
+    }
+  }
+
+  FaceSTScalar(x + i, y + i, z + i, count - i, face + i, s + i, t + i);
+}
+
+// Negation uses an integer xor because _mm512_xor_pd() requires AVX512DQ
+__attribute__((target("avx512f"))) inline __m512d Negate512(__m512d value) {
+  return _mm512_castsi512_pd(_mm512_xor_si512(
+      _mm512_castpd_si512(value), _mm512_set1_epi64(INT64_MIN)));
+}
+
+__attribute__((target("avx512f"))) void FaceSTAvx512(const double* x, const double* y,
+                                                     const double* z, idx_t count,
+                                                     int* face, double* s,
+                                                     double* t) {
+  const __m512d zero = _mm512_setzero_pd();
+  const __m512d half = _mm512_set1_pd(0.5);
+  const __m512d one = _mm512_set1_pd(1);
+  const __m512d three = _mm512_set1_pd(3);
+
+  idx_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m512d px = _mm512_loadu_pd(x + i);
+    __m512d py = _mm512_loadu_pd(y + i);
+    __m512d pz = _mm512_loadu_pd(z + i);
+    __m512d ax = _mm512_abs_pd(px);
+    __m512d ay = _mm512_abs_pd(py);
+    __m512d az = _mm512_abs_pd(pz);
+
+    __mmask8 x_gt_y = _mm512_cmp_pd_mask(ax, ay, _CMP_GT_OQ);
+    __mmask8 is_x = x_gt_y & _mm512_cmp_pd_mask(ax, az, _CMP_GT_OQ);
+    __mmask8 is_y = ~x_gt_y & _mm512_cmp_pd_mask(ay, az, _CMP_GT_OQ);
+
+    __m512d major = _mm512_mask_blend_pd(is_x, _mm512_mask_blend_pd(is_y, pz, py), px);
+    __m512d a = _mm512_mask_blend_pd(is_x, Negate512(px), py);
+    __m512d b = _mm512_mask_blend_pd(is_x | is_y, Negate512(py), pz);
+
+    __mmask8 neg = _mm512_cmp_pd_mask(major, zero, _CMP_LT_OQ);
+    __m512d u = _mm512_div_pd(_mm512_mask_blend_pd(neg, a, b), major);
+    __m512d v = _mm512_div_pd(_mm512_mask_blend_pd(neg, b, a), major);
+
+    __m512d ru = _mm512_mul_pd(
+        half, _mm512_sqrt_pd(_mm512_add_pd(one, _mm512_mul_pd(three, _mm512_abs_pd(u)))));
+    __m512d rv = _mm512_mul_pd(
+        half, _mm512_sqrt_pd(_mm512_add_pd(one, _mm512_mul_pd(three, _mm512_abs_pd(v)))));
+    _mm512_storeu_pd(s + i, _mm512_mask_blend_pd(_mm512_cmp_pd_mask(u, zero, _CMP_GE_OQ),
+                                                 _mm512_sub_pd(one, ru), ru));
+    _mm512_storeu_pd(t + i, _mm512_mask_blend_pd(_mm512_cmp_pd_mask(v, zero, _CMP_GE_OQ),
+                                                 _mm512_sub_pd(one, rv), rv));
+
+    for (int lane = 0; lane < 8; lane++) {
+      int f = (is_x >> lane & 1) ? 0 : ((is_y >> lane & 1) ? 1 : 2);
+      face[i + lane] = f + 3 * (neg >> lane & 1);
+    }
+  }
+
+  FaceSTScalar(x + i, y + i, z + i, count - i, face + i, s + i, t + i);
+}
+
+#endif
+
+FaceSTKernel ResolveFaceSTKernel() {
+#ifdef S2_LNGLAT_KERNELS_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    return FaceSTAvx512;
+  } else if (__builtin_cpu_supports("avx2")) {
+    return FaceSTAvx2;
+  }
+#endif
+
+  return FaceSTScalar;
+}
+
+}  // namespace
+
+void LngLatToCellIds(const double* lng, const double* lat, idx_t count, uint64_t* out) {
+  static const FaceSTKernel face_st = ResolveFaceSTKernel();
+
+  double x[kBlockSize];
+  double y[kBlockSize];
+  double z[kBlockSize];
+  int face[kBlockSize];
+  double s[kBlockSize];
+  double t[kBlockSize];
+
+  for (idx_t offset = 0; offset < count; offset += kBlockSize) {
+    idx_t n = std::min<idx_t>(kBlockSize, count - offset);
+    const double* block_lng = lng + offset;
+    const double* block_lat = lat + offset;
+    uint64_t* block_out = out + offset;
+
+    for (idx_t i = 0; i < n; i++) {
+      S2Point point = S2LatLng::FromDegrees(block_lat[i], block_lng[i]).ToPoint();
+      x[i] = point.x();
+      y[i] = point.y();
+      z[i] = point.z();
+    }
+
+    face_st(x, y, z, n, face, s, t);
+
+    for (idx_t i = 0; i < n; i++) {
+      if (std::isnan(block_lng[i]) && std::isnan(block_lat[i])) {
+        block_out[i] = S2CellId::Sentinel().id();
+      } else if (!std::isfinite(s[i]) || !std::isfinite(t[i])) {
+        // Leave any non-finite input to the scalar path so that whatever it
+        // does with it is preserved
+        block_out[i] = S2CellId(S2Point(x[i], y[i], z[i])).id();
+      } else {
+        block_out[i] =
+            S2CellId::FromFaceIJ(face[i], S2::STtoIJ(s[i]), S2::STtoIJ(t[i])).id();
+      }
+
+      D_ASSERT(std::isnan(block_lng[i]) ||
+               block_out[i] == S2CellId(S2Point(x[i], y[i], z[i])).id());
+    }
+  }
+}
+
+}  // namespace duckdb_s2
+}  // namespace duckdb
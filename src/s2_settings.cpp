@@ -0,0 +1,215 @@
+#include "duckdb/main/config.hpp"
+#include "duckdb/common/string_util.hpp"
+#include "duckdb/main/database.hpp"
+
+#include "s2_settings.hpp"
+
+namespace duckdb {
+
+namespace duckdb_s2 {
+
+namespace {
+
+constexpr const char* kCacheMemoryLimit = "s2_cache_memory_limit";
+constexpr const char* kCacheMemoryLimitDefault = "16MB";
+
+constexpr const char* kCodingHint = "s2_coding_hint";
+constexpr const char* kCodingHintDefault = "compact";
+
+constexpr const char* kEncodeExtensions = "s2_encode_extensions";
+constexpr bool kEncodeExtensionsDefault = false;
+
+constexpr const char* kEncodeInteriorCovering = "s2_encode_interior_covering";
+constexpr bool kEncodeInteriorCoveringDefault = false;
+
+constexpr const char* kCoveringMaxCells = "s2_covering_max_cells";
+constexpr int64_t kCoveringMaxCellsDefault = S2RegionCoverer::Options::kDefaultMaxCells;
+
+constexpr const char* kCoveringMaxLevel = "s2_covering_max_level";
+constexpr int64_t kCoveringMaxLevelDefault = S2CellId::kMaxLevel;
+
+constexpr const char* kPrepareThreshold = "s2_prepare_threshold";
+constexpr int64_t kPrepareThresholdDefault = 64;
+
+constexpr const char* kIndexMaxEdgesPerCell = "s2_index_max_edges_per_cell";
+constexpr int64_t kIndexMaxEdgesPerCellDefault = 10;
+
+void SetCacheMemoryLimit(ClientContext& context, SetScope scope, Value& parameter) {
+  // Validate the value when it is set rather than when it is used
+  DBConfig::ParseMemoryLimit(parameter.ToString());
+}
+
+s2coding::CodingHint ParseCodingHint(const string& value) {
+  auto value_lower = StringUtil::Lower(value);
+  if (value_lower == "compact") {
+    return s2coding::CodingHint::COMPACT;
+  } else if (value_lower == "fast") {
+    return s2coding::CodingHint::FAST;
+  } else {
+    throw InvalidInputException("%s must be one of 'compact' or 'fast' but got '%s'",
+                                kCodingHint, value);
+  }
+}
+
+void SetCodingHint(ClientContext& context, SetScope scope, Value& parameter) {
+  ParseCodingHint(parameter.ToString());
+}
+
+void CheckRange(const char* name, const Value& parameter, int64_t min_value,
+                int64_t max_value) {
+  auto value = parameter.GetValue<int64_t>();
+  if (value < min_value || value > max_value) {
+    throw InvalidInputException("%s must be between %d and %d but got %d", name,
+                                min_value, max_value, value);
+  }
+}
+
+void SetCoveringMaxCells(ClientContext& context, SetScope scope, Value& parameter) {
+  CheckRange(kCoveringMaxCells, parameter, 1, NumericLimits<int32_t>::Maximum());
+}
+
+void SetCoveringMaxLevel(ClientContext& context, SetScope scope, Value& parameter) {
+  CheckRange(kCoveringMaxLevel, parameter, 0, S2CellId::kMaxLevel);
+}
+
+void SetPrepareThreshold(ClientContext& context, SetScope scope, Value& parameter) {
+  CheckRange(kPrepareThreshold, parameter, 0, NumericLimits<int64_t>::Maximum());
+}
+
+void SetIndexMaxEdgesPerCell(ClientContext& context, SetScope scope, Value& parameter) {
+  CheckRange(kIndexMaxEdgesPerCell, parameter, 1, NumericLimits<int32_t>::Maximum());
+}
+
+int64_t GetIntegerSetting(ClientContext& context, const char* name,
+                          int64_t default_value) {
+  Value value;
+  if (!context.TryGetCurrentSetting(name, value) || value.IsNull()) {
+    return default_value;
+  }
+
+  return value.GetValue<int64_t>();
+}
+
+bool GetBooleanSetting(ClientContext& context, const char* name, bool default_value) {
+  Value value;
+  if (!context.TryGetCurrentSetting(name, value) || value.IsNull()) {
+    return default_value;
+  }
+
+  return value.GetValue<bool>();
+}
+
+}  // namespace
+
+idx_t GetCacheMemoryLimit(ClientContext& context) {
+  Value value;
+  if (!context.TryGetCurrentSetting(kCacheMemoryLimit, value) || value.IsNull()) {
+    return DBConfig::ParseMemoryLimit(kCacheMemoryLimitDefault);
+  }
+
+  return DBConfig::ParseMemoryLimit(value.ToString());
+}
+
+s2coding::CodingHint GetCodingHint(ClientContext& context) {
+  Value value;
+  if (!context.TryGetCurrentSetting(kCodingHint, value) || value.IsNull()) {
+    return ParseCodingHint(kCodingHintDefault);
+  }
+
+  return ParseCodingHint(value.ToString());
+}
+
+void InitCovererOptions(ClientContext& context, S2RegionCoverer::Options* options) {
+  options->set_max_cells(static_cast<int>(
+      GetIntegerSetting(context, kCoveringMaxCells, kCoveringMaxCellsDefault)));
+  options->set_max_level(static_cast<int>(
+      GetIntegerSetting(context, kCoveringMaxLevel, kCoveringMaxLevelDefault)));
+}
+
+void InitGeographyEncoder(ClientContext& context, GeographyEncoder* encoder) {
+  encoder->set_coding_hint(GetCodingHint(context));
+
+  encoder->set_include_bounds(
+      GetBooleanSetting(context, kEncodeExtensions, kEncodeExtensionsDefault));
+  encoder->set_include_interior_covering(GetBooleanSetting(
+      context, kEncodeInteriorCovering, kEncodeInteriorCoveringDefault));
+
+  // With the default options, keep the covering computed by s2geography, which
+  // is much cheaper than running an S2RegionCoverer for every value
+  S2RegionCoverer::Options covering_options;
+  InitCovererOptions(context, &covering_options);
+  if (covering_options.max_cells() != kCoveringMaxCellsDefault ||
+      covering_options.max_level() != kCoveringMaxLevelDefault) {
+    encoder->set_covering_options(covering_options);
+  } else {
+    encoder->clear_covering_options();
+  }
+}
+
+idx_t GetPrepareThreshold(ClientContext& context) {
+  return static_cast<idx_t>(
+      GetIntegerSetting(context, kPrepareThreshold, kPrepareThresholdDefault));
+}
+
+void InitShapeIndexOptions(ClientContext& context,
+                           MutableS2ShapeIndex::Options* options) {
+  options->set_max_edges_per_cell(static_cast<int>(
+      GetIntegerSetting(context, kIndexMaxEdgesPerCell, kIndexMaxEdgesPerCellDefault)));
+}
+
+void RegisterSettings(DatabaseInstance& instance) {
+  auto& config = DBConfig::GetConfig(instance);
+
+  config.AddExtensionOption(
+      kCacheMemoryLimit,
+      "Maximum memory used by each thread to cache decoded and indexed geographies "
+      "for each predicate or overlay (e.g., '16MB'; '0' disables the cache)",
+      LogicalType::VARCHAR, Value(kCacheMemoryLimitDefault), SetCacheMemoryLimit);
+
+  config.AddExtensionOption(
+      kCodingHint,
+      "Encoding used for the coordinates of new GEOGRAPHY values: 'compact' (smaller) "
+      "or 'fast' (quicker to decode)",
+      LogicalType::VARCHAR, Value(kCodingHintDefault), SetCodingHint);
+
+  config.AddExtensionOption(
+      kEncodeExtensions,
+      "Store the bounds of new non-point GEOGRAPHY values such that they can be used "
+      "without decoding the value (values with these can't be read by earlier "
+      "versions of this extension or by s2geography)",
+      LogicalType::BOOLEAN, Value::BOOLEAN(kEncodeExtensionsDefault));
+
+  config.AddExtensionOption(
+      kEncodeInteriorCovering,
+      "Store an interior covering of new polygon GEOGRAPHY values such that predicates "
+      "can prove containment without an exact test (slower to encode; values with "
+      "these can't be read by earlier versions of this extension or by s2geography)",
+      LogicalType::BOOLEAN, Value::BOOLEAN(kEncodeInteriorCoveringDefault));
+
+  config.AddExtensionOption(
+      kCoveringMaxCells,
+      "Maximum number of cells returned by s2_covering() and, if changed from the "
+      "default, in the covering stored with new GEOGRAPHY values",
+      LogicalType::BIGINT, Value::BIGINT(kCoveringMaxCellsDefault), SetCoveringMaxCells);
+
+  config.AddExtensionOption(
+      kCoveringMaxLevel,
+      "Maximum level of cells returned by s2_covering() and, if changed from the "
+      "default, in the covering stored with new GEOGRAPHY values",
+      LogicalType::BIGINT, Value::BIGINT(kCoveringMaxLevelDefault), SetCoveringMaxLevel);
+
+  config.AddExtensionOption(
+      kPrepareThreshold,
+      "Encoded size in bytes below which s2_prepare() returns its input unchanged",
+      LogicalType::BIGINT, Value::BIGINT(kPrepareThresholdDefault), SetPrepareThreshold);
+
+  config.AddExtensionOption(
+      kIndexMaxEdgesPerCell,
+      "Maximum number of edges per cell in the index built by s2_prepare() "
+      "(smaller values build larger indexes that are faster to query)",
+      LogicalType::BIGINT, Value::BIGINT(kIndexMaxEdgesPerCellDefault),
+      SetIndexMaxEdgesPerCell);
+}
+
+}  // namespace duckdb_s2
+}  // namespace duckdb
@@ -0,0 +1,846 @@
+#include "duckdb/common/types/column/column_data_collection.hpp"
+#include "duckdb/execution/column_binding_resolver.hpp"
+#include "duckdb/execution/expression_executor.hpp"
+#include "duckdb/execution/operator/join/physical_join.hpp"
+#include "duckdb/execution/physical_plan_generator.hpp"
+#include "duckdb/main/config.hpp"
+#include "duckdb/main/database.hpp"
+#include "duckdb/optimizer/optimizer_extension.hpp"
+#include "duckdb/planner/expression/bound_function_expression.hpp"
+#include "duckdb/planner/expression/bound_reference_expression.hpp"
+#include "duckdb/planner/joinside.hpp"
+#include "duckdb/planner/operator/logical_any_join.hpp"
+#include "duckdb/planner/operator/logical_extension_operator.hpp"
+
+#include "s2/mutable_s2shape_index.h"
+#include "s2/s2cell_id.h"
+#include "s2/s2closest_edge_query.h"
+#include "s2/s2earth.h"
+
+#include "function_builder.hpp"
+#include "s2_geography_serde.hpp"
+#include "s2_prepared_geography.hpp"
+#include "s2_spatial_join.hpp"
+#include "s2_types.hpp"
+
+namespace duckdb {
+
+namespace duckdb_s2 {
+
+namespace {
+
+// One entry for every cell in the covering of every geography on the build
+// side of the join. Entries are sorted by cell_id such that all cells contained
+// by a probe cell are a contiguous range [range_min, range_max] and all cells
+// containing a probe cell can be found by looking up its parents.
+struct CellEntry {
+  uint64_t cell_id;
+  uint32_t row;
+
+  bool operator<(const CellEntry& other) const { return cell_id < other.cell_id; }
+};
+
+//------------------------------------------------------------------------------
+// Physical operator
+//------------------------------------------------------------------------------
+
+class S2SpatialJoinGlobalSinkState : public GlobalSinkState {
+ public:
+  S2SpatialJoinGlobalSinkState(ClientContext& context, const vector<LogicalType>& types)
+      : collection(context, types) {}
+
+  mutex lock;
+  ColumnDataCollection collection;
+
+  // Populated in Finalize(): the materialized build side (with the join key
+  // as the last column) and the sorted cell entries that point into it.
+  DataChunk build;
+  vector<CellEntry> cells;
+
+  // Non-empty build rows without a covering are candidates for every probe row
+  vector<uint32_t> uncovered;
+
+  // For nearest neighbour joins, the shapes of every build geography are
+  // indexed instead (with shape_rows mapping shape ids to build rows)
+  vector<unique_ptr<s2geography::Geography>> geographies;
+  MutableS2ShapeIndex index;
+  vector<uint32_t> shape_rows;
+};
+
+class S2SpatialJoinLocalSinkState : public LocalSinkState {
+ public:
+  S2SpatialJoinLocalSinkState(ClientContext& context, const Expression& build_key,
+                              const vector<LogicalType>& types)
+      : executor(context, build_key) {
+    keys.Initialize(Allocator::Get(context), {build_key.return_type});
+    payload.Initialize(Allocator::Get(context), types);
+    collection = make_uniq<ColumnDataCollection>(context, types);
+  }
+
+  ExpressionExecutor executor;
+  DataChunk keys;
+  DataChunk payload;
+  unique_ptr<ColumnDataCollection> collection;
+};
+
+class S2SpatialJoinState : public CachingOperatorState {
+ public:
+  // predicate is nullptr for a nearest neighbour join, for which every
+  // candidate is a match
+  S2SpatialJoinState(ClientContext& context, const Expression& probe_key,
+                     optional_ptr<Expression> predicate)
+      : probe_executor(context, probe_key),
+        predicate_executor(context),
+        lhs_sel(STANDARD_VECTOR_SIZE),
+        rhs_sel(STANDARD_VECTOR_SIZE),
+        match_sel(STANDARD_VECTOR_SIZE),
+        out_lhs_sel(STANDARD_VECTOR_SIZE),
+        out_rhs_sel(STANDARD_VECTOR_SIZE) {
+    probe_keys.Initialize(Allocator::Get(context), {probe_key.return_type});
+    if (predicate) {
+      predicate_executor.AddExpression(*predicate);
+      auto& predicate_func = predicate->Cast<BoundFunctionExpression>();
+      pair_keys.Initialize(Allocator::Get(context),
+                           {predicate_func.children[0]->return_type,
+                            predicate_func.children[1]->return_type});
+    }
+  }
+
+  ExpressionExecutor probe_executor;
+  ExpressionExecutor predicate_executor;
+  DataChunk probe_keys;
+  DataChunk pair_keys;
+  UnifiedVectorFormat probe_format;
+
+  // Position within the current input chunk
+  bool initialized_input{false};
+  idx_t next_probe_row{0};
+  idx_t current_probe_row{0};
+  vector<uint32_t> candidates;
+  idx_t candidate_offset{0};
+
+  GeographyDecoder decoder;
+
+  // For nearest neighbour joins
+  PreparedGeography probe_geog;
+  unique_ptr<S2ClosestEdgeQuery> knn_query;
+  unordered_set<uint32_t> knn_seen;
+
+  SelectionVector lhs_sel;
+  SelectionVector rhs_sel;
+  SelectionVector match_sel;
+  SelectionVector out_lhs_sel;
+  SelectionVector out_rhs_sel;
+};
+
+class PhysicalS2SpatialJoin : public PhysicalJoin {
+ public:
+  PhysicalS2SpatialJoin(LogicalOperator& op, unique_ptr<PhysicalOperator> left,
+                        unique_ptr<PhysicalOperator> right,
+                        unique_ptr<Expression> probe_key_p,
+                        unique_ptr<Expression> build_key_p,
+                        unique_ptr<Expression> predicate_p, idx_t probe_arg_p,
+                        double covering_distance_p, idx_t knn_k_p,
+                        double knn_max_distance_p,
+                        vector<idx_t> left_projection_map_p,
+                        vector<idx_t> right_projection_map_p,
+                        idx_t estimated_cardinality)
+      : PhysicalJoin(op, PhysicalOperatorType::EXTENSION, JoinType::INNER,
+                     estimated_cardinality),
+        probe_key(std::move(probe_key_p)),
+        build_key(std::move(build_key_p)),
+        predicate(std::move(predicate_p)),
+        probe_arg(probe_arg_p),
+        covering_distance(covering_distance_p),
+        knn_k(knn_k_p),
+        knn_max_distance(knn_max_distance_p),
+        left_projection_map(std::move(left_projection_map_p)),
+        right_projection_map(std::move(right_projection_map_p)) {
+    children.push_back(std::move(left));
+    children.push_back(std::move(right));
+
+    build_types = children[1]->types;
+    build_types.push_back(build_key->return_type);
+  }
+
+  // Evaluated against the probe (left) and build (right) children
+  unique_ptr<Expression> probe_key;
+  unique_ptr<Expression> build_key;
+
+  // The original join condition with its arguments replaced by references
+  // to column 0 and 1 of a two-column chunk of candidate pairs
+  unique_ptr<Expression> predicate;
+  idx_t probe_arg;
+
+  // For s2_dwithin() joins, the distance in meters by which build coverings
+  // are expanded before they are compared to probe coverings
+  double covering_distance;
+
+  // For a nearest neighbour join (s2_knn()), the number of build rows to
+  // match for each probe row and the maximum distance in meters. knn_k is 0
+  // for predicate joins.
+  idx_t knn_k;
+  double knn_max_distance;
+
+  vector<idx_t> left_projection_map;
+  vector<idx_t> right_projection_map;
+  vector<LogicalType> build_types;
+
+  string GetName() const override { return "S2_SPATIAL_JOIN"; }
+
+  // Sink interface (build side)
+  bool IsSink() const override { return true; }
+  bool ParallelSink() const override { return true; }
+
+  unique_ptr<GlobalSinkState> GetGlobalSinkState(ClientContext& context) const override {
+    return make_uniq<S2SpatialJoinGlobalSinkState>(context, build_types);
+  }
+
+  unique_ptr<LocalSinkState> GetLocalSinkState(ExecutionContext& context) const override {
+    return make_uniq<S2SpatialJoinLocalSinkState>(context.client, *build_key,
+                                                  build_types);
+  }
+
+  SinkResultType Sink(ExecutionContext& context, DataChunk& chunk,
+                      OperatorSinkInput& input) const override {
+    auto& lstate = input.local_state.Cast<S2SpatialJoinLocalSinkState>();
+
+    lstate.keys.Reset();
+    lstate.executor.Execute(chunk, lstate.keys);
+
+    lstate.payload.Reset();
+    for (idx_t i = 0; i < chunk.ColumnCount(); i++) {
+      lstate.payload.data[i].Reference(chunk.data[i]);
+    }
+    lstate.payload.data[chunk.ColumnCount()].Reference(lstate.keys.data[0]);
+    lstate.payload.SetCardinality(chunk.size());
+
+    lstate.collection->Append(lstate.payload);
+    return SinkResultType::NEED_MORE_INPUT;
+  }
+
+  SinkCombineResultType Combine(ExecutionContext& context,
+                                OperatorSinkCombineInput& input) const override {
+    auto& gstate = input.global_state.Cast<S2SpatialJoinGlobalSinkState>();
+    auto& lstate = input.local_state.Cast<S2SpatialJoinLocalSinkState>();
+
+    lock_guard<mutex> guard(gstate.lock);
+    gstate.collection.Combine(*lstate.collection);
+    return SinkCombineResultType::FINISHED;
+  }
+
+  SinkFinalizeType Finalize(Pipeline& pipeline, Event& event, ClientContext& context,
+                            OperatorSinkFinalizeInput& input) const override {
+    auto& gstate = input.global_state.Cast<S2SpatialJoinGlobalSinkState>();
+    idx_t count = gstate.collection.Count();
+    if (count == 0) {
+      return SinkFinalizeType::NO_OUTPUT_POSSIBLE;
+    }
+
+    if (count > NumericLimits<uint32_t>::Maximum()) {
+      throw NotImplementedException(
+          "S2_SPATIAL_JOIN: build side with more than 2^32 rows not supported");
+    }
+
+    // Materialize the build side so that it can be referenced by row
+    gstate.build.Initialize(Allocator::Get(context), build_types, count);
+    for (auto& chunk : gstate.collection.Chunks()) {
+      gstate.build.Append(chunk);
+    }
+    gstate.collection.Reset();
+
+    Vector& keys = gstate.build.data[build_types.size() - 1];
+    UnifiedVectorFormat keys_format;
+    keys.ToUnifiedFormat(count, keys_format);
+    auto keys_data = UnifiedVectorFormat::GetData<string_t>(keys_format);
+
+    GeographyDecoder decoder;
+
+    if (knn_k > 0) {
+      // Index the edges of every build geography. The decoded geographies
+      // refer to the materialized build keys and must be kept alive.
+      for (idx_t i = 0; i < count; i++) {
+        idx_t key_idx = keys_format.sel->get_index(i);
+        if (!keys_format.validity.RowIsValid(key_idx)) {
+          continue;
+        }
+
+        decoder.DecodeTag(keys_data[key_idx]);
+        if (decoder.tag.flags & s2geography::EncodeTag::kFlagEmpty) {
+          continue;
+        }
+
+        auto geog = decoder.Decode(keys_data[key_idx]);
+        for (int j = 0; j < geog->num_shapes(); j++) {
+          gstate.index.Add(geog->Shape(j));
+          gstate.shape_rows.push_back(static_cast<uint32_t>(i));
+        }
+        gstate.geographies.push_back(std::move(geog));
+      }
+
+      gstate.index.ForceBuild();
+      return SinkFinalizeType::READY;
+    }
+
+    // Unnest the coverings that are stored alongside each geography
+    for (idx_t i = 0; i < count; i++) {
+      idx_t key_idx = keys_format.sel->get_index(i);
+      if (!keys_format.validity.RowIsValid(key_idx)) {
+        continue;
+      }
+
+      decoder.DecodeTagAndCovering(keys_data[key_idx]);
+      if (decoder.tag.flags & s2geography::EncodeTag::kFlagEmpty) {
+        continue;
+      }
+
+      if (decoder.covering.empty()) {
+        gstate.uncovered.push_back(static_cast<uint32_t>(i));
+        continue;
+      }
+
+      if (covering_distance > 0) {
+        decoder.covering = ExpandCovering(decoder.covering, covering_distance);
+      }
+
+      for (const S2CellId cell_id : decoder.covering) {
+        gstate.cells.push_back({cell_id.id(), static_cast<uint32_t>(i)});
+      }
+    }
+
+    std::sort(gstate.cells.begin(), gstate.cells.end());
+    return SinkFinalizeType::READY;
+  }
+
+  // Operator interface (probe side)
+  bool ParallelOperator() const override { return true; }
+
+  unique_ptr<OperatorState> GetOperatorState(ExecutionContext& context) const override {
+    return make_uniq<S2SpatialJoinState>(context.client, *probe_key, predicate.get());
+  }
+
+ protected:
+  OperatorResultType ExecuteInternal(ExecutionContext& context, DataChunk& input,
+                                     DataChunk& chunk, GlobalOperatorState& gstate_p,
+                                     OperatorState& state_p) const override {
+    auto& gstate = sink_state->Cast<S2SpatialJoinGlobalSinkState>();
+    auto& state = state_p.Cast<S2SpatialJoinState>();
+
+    if (!state.initialized_input) {
+      state.probe_keys.Reset();
+      state.probe_executor.Execute(input, state.probe_keys);
+      state.probe_keys.data[0].ToUnifiedFormat(input.size(), state.probe_format);
+      state.next_probe_row = 0;
+      state.candidates.clear();
+      state.candidate_offset = 0;
+      state.initialized_input = true;
+    }
+
+    idx_t match_count = 0;
+    while (match_count == 0 && !ProbeFinished(state, input)) {
+      // Collect up to one vector's worth of candidate pairs
+      idx_t pair_count = 0;
+      while (pair_count < STANDARD_VECTOR_SIZE) {
+        if (state.candidate_offset >= state.candidates.size()) {
+          if (state.next_probe_row >= input.size()) {
+            break;
+          }
+
+          state.current_probe_row = state.next_probe_row++;
+          if (knn_k > 0) {
+            FindNearestCandidates(gstate, state);
+          } else {
+            FindCandidates(gstate, state);
+          }
+          continue;
+        }
+
+        state.lhs_sel.set_index(pair_count, state.current_probe_row);
+        state.rhs_sel.set_index(pair_count, state.candidates[state.candidate_offset++]);
+        pair_count++;
+      }
+
+      if (pair_count == 0) {
+        break;
+      }
+
+      // Nearest neighbour candidates are all matches
+      if (!predicate) {
+        for (idx_t i = 0; i < pair_count; i++) {
+          state.out_lhs_sel.set_index(i, state.lhs_sel.get_index(i));
+          state.out_rhs_sel.set_index(i, state.rhs_sel.get_index(i));
+        }
+        match_count = pair_count;
+        break;
+      }
+
+      // Run the exact predicate on the candidates only
+      Vector& build_keys = gstate.build.data[build_types.size() - 1];
+      state.pair_keys.Reset();
+      state.pair_keys.data[probe_arg].Slice(state.probe_keys.data[0], state.lhs_sel,
+                                            pair_count);
+      state.pair_keys.data[1 - probe_arg].Slice(build_keys, state.rhs_sel, pair_count);
+      state.pair_keys.SetCardinality(pair_count);
+      match_count =
+          state.predicate_executor.SelectExpression(state.pair_keys, state.match_sel);
+
+      for (idx_t i = 0; i < match_count; i++) {
+        idx_t pair_idx = state.match_sel.get_index(i);
+        state.out_lhs_sel.set_index(i, state.lhs_sel.get_index(pair_idx));
+        state.out_rhs_sel.set_index(i, state.rhs_sel.get_index(pair_idx));
+      }
+    }
+
+    idx_t left_cols = left_projection_map.empty() ? children[0]->types.size()
+                                                  : left_projection_map.size();
+    for (idx_t i = 0; i < left_cols; i++) {
+      idx_t col = left_projection_map.empty() ? i : left_projection_map[i];
+      chunk.data[i].Slice(input.data[col], state.out_lhs_sel, match_count);
+    }
+
+    idx_t right_cols = right_projection_map.empty() ? children[1]->types.size()
+                                                    : right_projection_map.size();
+    for (idx_t i = 0; i < right_cols; i++) {
+      idx_t col = right_projection_map.empty() ? i : right_projection_map[i];
+      chunk.data[left_cols + i].Slice(gstate.build.data[col], state.out_rhs_sel,
+                                      match_count);
+    }
+
+    chunk.SetCardinality(match_count);
+
+    if (ProbeFinished(state, input)) {
+      state.initialized_input = false;
+      return OperatorResultType::NEED_MORE_INPUT;
+    } else {
+      return OperatorResultType::HAVE_MORE_OUTPUT;
+    }
+  }
+
+ private:
+  static bool ProbeFinished(const S2SpatialJoinState& state, const DataChunk& input) {
+    return state.next_probe_row >= input.size() &&
+           state.candidate_offset >= state.candidates.size();
+  }
+
+  // Populate state.candidates with the knn_k build rows closest to the current
+  // probe row (in order of increasing distance)
+  void FindNearestCandidates(S2SpatialJoinGlobalSinkState& gstate,
+                             S2SpatialJoinState& state) const {
+    state.candidates.clear();
+    state.candidate_offset = 0;
+
+    idx_t key_idx = state.probe_format.sel->get_index(state.current_probe_row);
+    if (!state.probe_format.validity.RowIsValid(key_idx)) {
+      return;
+    }
+
+    auto keys_data = UnifiedVectorFormat::GetData<string_t>(state.probe_format);
+    auto& probe_geog = state.probe_geog.Init(keys_data[key_idx]);
+    if (probe_geog.IsEmpty()) {
+      return;
+    }
+
+    if (!state.knn_query) {
+      state.knn_query = make_uniq<S2ClosestEdgeQuery>(&gstate.index);
+      state.knn_query->mutable_options()->set_include_interiors(true);
+      if (knn_max_distance < std::numeric_limits<double>::infinity()) {
+        state.knn_query->mutable_options()->set_inclusive_max_distance(
+            S1ChordAngle(S1Angle::Radians(knn_max_distance / S2Earth::RadiusMeters())));
+      }
+    }
+
+    // Points (the most common case) can use a cheaper target
+    unique_ptr<S2MinDistanceTarget> target;
+    unique_ptr<s2geography::Geography> point_geog;
+    if (probe_geog.Kind() == s2geography::GeographyKind::POINT ||
+        probe_geog.Kind() == s2geography::GeographyKind::CELL_CENTER) {
+      point_geog = state.decoder.Decode(probe_geog.Data());
+    }
+
+    auto points = dynamic_cast<s2geography::PointGeography*>(point_geog.get());
+    if (points && points->Points().size() == 1) {
+      target = make_uniq<S2ClosestEdgeQuery::PointTarget>(points->Points()[0]);
+    } else {
+      auto index_target = make_uniq<S2ClosestEdgeQuery::ShapeIndexTarget>(
+          &probe_geog.Prepare().ShapeIndex());
+      index_target->set_include_interiors(true);
+      target = std::move(index_target);
+    }
+
+    // Results are edges (or polygon interiors), so several results may refer
+    // to the same build row. Keep asking for more results until we have
+    // knn_k distinct rows or there are no more results.
+    int max_results = static_cast<int>(knn_k);
+    while (true) {
+      state.knn_query->mutable_options()->set_max_results(max_results);
+      auto results = state.knn_query->FindClosestEdges(target.get());
+
+      state.candidates.clear();
+      state.knn_seen.clear();
+      for (const auto& result : results) {
+        uint32_t row = gstate.shape_rows[result.shape_id()];
+        if (state.knn_seen.insert(row).second) {
+          state.candidates.push_back(row);
+          if (state.candidates.size() == knn_k) {
+            break;
+          }
+        }
+      }
+
+      if (state.candidates.size() == knn_k ||
+          static_cast<int>(results.size()) < max_results ||
+          max_results > std::numeric_limits<int>::max() / 2) {
+        break;
+      }
+
+      max_results *= 2;
+    }
+  }
+
+  // Populate state.candidates with the (deduplicated) build rows whose covering
+  // intersects the covering of the current probe row
+  static void FindCandidates(const S2SpatialJoinGlobalSinkState& gstate,
+                             S2SpatialJoinState& state) {
+    state.candidates.clear();
+    state.candidate_offset = 0;
+
+    idx_t key_idx = state.probe_format.sel->get_index(state.current_probe_row);
+    if (!state.probe_format.validity.RowIsValid(key_idx)) {
+      return;
+    }
+
+    auto keys_data = UnifiedVectorFormat::GetData<string_t>(state.probe_format);
+    state.decoder.DecodeTagAndCovering(keys_data[key_idx]);
+    if (state.decoder.tag.flags & s2geography::EncodeTag::kFlagEmpty) {
+      return;
+    }
+
+    // Without a covering we can't rule anything out
+    if (state.decoder.covering.empty()) {
+      for (idx_t i = 0; i < gstate.build.size(); i++) {
+        state.candidates.push_back(static_cast<uint32_t>(i));
+      }
+      return;
+    }
+
+    const auto& cells = gstate.cells;
+    for (const S2CellId cell_id : state.decoder.covering) {
+      // Build cells equal to or contained by this cell
+      auto begin = std::lower_bound(cells.begin(), cells.end(),
+                                    CellEntry{cell_id.range_min().id(), 0});
+      for (auto it = begin; it != cells.end() && it->cell_id <= cell_id.range_max().id();
+           ++it) {
+        state.candidates.push_back(it->row);
+      }
+
+      // Build cells containing this cell
+      for (int level = cell_id.level() - 1; level >= 0; level--) {
+        auto range = std::equal_range(cells.begin(), cells.end(),
+                                      CellEntry{cell_id.parent(level).id(), 0});
+        for (auto it = range.first; it != range.second; ++it) {
+          state.candidates.push_back(it->row);
+        }
+      }
+    }
+
+    state.candidates.insert(state.candidates.end(), gstate.uncovered.begin(),
+                            gstate.uncovered.end());
+    std::sort(state.candidates.begin(), state.candidates.end());
+    state.candidates.erase(std::unique(state.candidates.begin(), state.candidates.end()),
+                           state.candidates.end());
+  }
+};
+
+//------------------------------------------------------------------------------
+// Logical operator
+//------------------------------------------------------------------------------
+
+class LogicalS2SpatialJoin : public LogicalExtensionOperator {
+ public:
+  // expressions[0] is the probe (left) key, expressions[1] is the build (right) key
+  LogicalS2SpatialJoin(unique_ptr<Expression> probe_key, unique_ptr<Expression> build_key,
+                       unique_ptr<Expression> predicate_p, idx_t probe_arg_p)
+      : predicate(std::move(predicate_p)), probe_arg(probe_arg_p) {
+    expressions.push_back(std::move(probe_key));
+    expressions.push_back(std::move(build_key));
+  }
+
+  unique_ptr<Expression> predicate;
+  idx_t probe_arg;
+  double covering_distance{0};
+  idx_t knn_k{0};
+  double knn_max_distance{std::numeric_limits<double>::infinity()};
+  vector<idx_t> left_projection_map;
+  vector<idx_t> right_projection_map;
+
+  string GetExtensionName() const override { return "s2_spatial_join"; }
+
+  vector<ColumnBinding> GetColumnBindings() override {
+    auto left_bindings =
+        MapBindings(children[0]->GetColumnBindings(), left_projection_map);
+    auto right_bindings =
+        MapBindings(children[1]->GetColumnBindings(), right_projection_map);
+    left_bindings.insert(left_bindings.end(), right_bindings.begin(),
+                         right_bindings.end());
+    return left_bindings;
+  }
+
+  // Like a join, each key is resolved against the bindings of its own child
+  void ResolveColumnBindings(ColumnBindingResolver& res,
+                             vector<ColumnBinding>& bindings) override {
+    res.VisitOperator(*children[0]);
+    res.VisitExpression(&expressions[0]);
+    res.VisitOperator(*children[1]);
+    res.VisitExpression(&expressions[1]);
+    bindings = GetColumnBindings();
+  }
+
+  unique_ptr<PhysicalOperator> CreatePlan(ClientContext& context,
+                                          PhysicalPlanGenerator& generator) override {
+    auto left = generator.CreatePlan(std::move(children[0]));
+    auto right = generator.CreatePlan(std::move(children[1]));
+    return make_uniq<PhysicalS2SpatialJoin>(
+        *this, std::move(left), std::move(right), std::move(expressions[0]),
+        std::move(expressions[1]), std::move(predicate), probe_arg, covering_distance,
+        knn_k, knn_max_distance, std::move(left_projection_map),
+        std::move(right_projection_map),
+        estimated_cardinality);
+  }
+
+ protected:
+  void ResolveTypes() override {
+    types = MapTypes(children[0]->types, left_projection_map);
+    auto right_types = MapTypes(children[1]->types, right_projection_map);
+    types.insert(types.end(), right_types.begin(), right_types.end());
+  }
+};
+
+//------------------------------------------------------------------------------
+// Optimizer
+//------------------------------------------------------------------------------
+
+// Predicates for which intersecting coverings are a necessary condition
+bool IsCoveringJoinPredicate(const string& name) {
+  return name == "s2_intersects" || name == "s2_contains" || name == "s2_equals" ||
+         name == "s2_mayintersect";
+}
+
+// s2_knn(geog1, geog2, k[, max_distance]) is not a predicate but marks a join
+// that matches each row of the geog1 side to the k closest rows of the geog2
+// side. Returns nullptr if op was not rewritten.
+unique_ptr<LogicalOperator> TryRewriteKnnJoin(ClientContext& context,
+                                              LogicalAnyJoin& join,
+                                              BoundFunctionExpression& condition,
+                                              JoinSide side0, JoinSide side1) {
+  for (idx_t i = 2; i < condition.children.size(); i++) {
+    if (!condition.children[i]->IsFoldable()) {
+      throw InvalidInputException("s2_knn(): k and max_distance must be constant");
+    }
+  }
+
+  // k is passed to the S2ClosestEdgeQuery as an int
+  Value k_value = ExpressionExecutor::EvaluateScalar(context, *condition.children[2]);
+  if (k_value.IsNull() || k_value.GetValue<int64_t>() < 1 ||
+      k_value.GetValue<int64_t>() > std::numeric_limits<int>::max()) {
+    throw InvalidInputException(
+        "s2_knn(): k must be a positive integer no greater than %d",
+        std::numeric_limits<int>::max());
+  }
+
+  double max_distance = std::numeric_limits<double>::infinity();
+  if (condition.children.size() == 4) {
+    Value max_distance_value =
+        ExpressionExecutor::EvaluateScalar(context, *condition.children[3]);
+    if (!max_distance_value.IsNull()) {
+      max_distance = max_distance_value.GetValue<double>();
+    }
+  }
+
+  // The geog1 side is always the probe side, so swap the children if needed
+  // (columns are resolved by binding, so this doesn't change the output)
+  if (side0 == JoinSide::RIGHT) {
+    std::swap(join.children[0], join.children[1]);
+    std::swap(join.left_projection_map, join.right_projection_map);
+  }
+
+  auto spatial_join = make_uniq<LogicalS2SpatialJoin>(
+      condition.children[0]->Copy(), condition.children[1]->Copy(), nullptr, 0);
+  spatial_join->knn_k = static_cast<idx_t>(k_value.GetValue<int64_t>());
+  spatial_join->knn_max_distance = max_distance;
+  spatial_join->left_projection_map = join.left_projection_map;
+  spatial_join->right_projection_map = join.right_projection_map;
+  spatial_join->children = std::move(join.children);
+  auto& probe = *spatial_join->children[0];
+  auto& build = *spatial_join->children[1];
+  if (probe.has_estimated_cardinality) {
+    // Each probe row matches at most k rows and at most every build row
+    idx_t probe_cardinality = probe.estimated_cardinality;
+    idx_t matches_per_row = spatial_join->knn_k;
+    if (build.has_estimated_cardinality) {
+      idx_t build_cardinality = MaxValue<idx_t>(build.estimated_cardinality, 1);
+      matches_per_row = MinValue<idx_t>(matches_per_row, build_cardinality);
+    }
+
+    if (probe_cardinality > NumericLimits<idx_t>::Maximum() / matches_per_row) {
+      spatial_join->SetEstimatedCardinality(NumericLimits<idx_t>::Maximum());
+    } else {
+      spatial_join->SetEstimatedCardinality(probe_cardinality * matches_per_row);
+    }
+  }
+
+  return std::move(spatial_join);
+}
+
+void TryRewriteJoin(ClientContext& context, unique_ptr<LogicalOperator>& op) {
+  for (auto& child : op->children) {
+    TryRewriteJoin(context, child);
+  }
+
+  if (op->type != LogicalOperatorType::LOGICAL_ANY_JOIN) {
+    return;
+  }
+
+  auto& join = op->Cast<LogicalAnyJoin>();
+  if (join.join_type != JoinType::INNER ||
+      join.condition->GetExpressionClass() != ExpressionClass::BOUND_FUNCTION) {
+    return;
+  }
+
+  auto& condition = join.condition->Cast<BoundFunctionExpression>();
+  bool is_knn = condition.function.name == "s2_knn";
+
+  // s2_dwithin() with a constant distance can use coverings that are expanded
+  // by that distance
+  double covering_distance = 0;
+  if (condition.function.name == "s2_dwithin" && condition.children.size() == 3) {
+    if (!condition.children[2]->IsFoldable()) {
+      return;
+    }
+
+    Value distance = ExpressionExecutor::EvaluateScalar(context, *condition.children[2]);
+    if (distance.IsNull()) {
+      return;
+    }
+
+    covering_distance = MaxValue<double>(distance.GetValue<double>(), 0);
+  } else if (!is_knn && (!IsCoveringJoinPredicate(condition.function.name) ||
+                         condition.children.size() != 2)) {
+    return;
+  }
+
+  // One argument must come from each side of the join
+  unordered_set<idx_t> left_bindings;
+  unordered_set<idx_t> right_bindings;
+  LogicalJoin::GetTableReferences(*join.children[0], left_bindings);
+  LogicalJoin::GetTableReferences(*join.children[1], right_bindings);
+
+  auto side0 =
+      JoinSide::GetJoinSide(*condition.children[0], left_bindings, right_bindings);
+  auto side1 =
+      JoinSide::GetJoinSide(*condition.children[1], left_bindings, right_bindings);
+
+  idx_t probe_arg;
+  if (side0 == JoinSide::LEFT && side1 == JoinSide::RIGHT) {
+    probe_arg = 0;
+  } else if (side0 == JoinSide::RIGHT && side1 == JoinSide::LEFT) {
+    probe_arg = 1;
+  } else {
+    return;
+  }
+
+  if (is_knn) {
+    op = TryRewriteKnnJoin(context, join, condition, side0, side1);
+    return;
+  }
+
+  auto probe_key = condition.children[probe_arg]->Copy();
+  auto build_key = condition.children[1 - probe_arg]->Copy();
+
+  auto predicate = condition.Copy();
+  auto& predicate_func = predicate->Cast<BoundFunctionExpression>();
+  for (idx_t i = 0; i < 2; i++) {
+    auto type = predicate_func.children[i]->return_type;
+    predicate_func.children[i] = make_uniq<BoundReferenceExpression>(type, i);
+  }
+
+  auto spatial_join = make_uniq<LogicalS2SpatialJoin>(
+      std::move(probe_key), std::move(build_key), std::move(predicate), probe_arg);
+  spatial_join->covering_distance = covering_distance;
+  spatial_join->left_projection_map = join.left_projection_map;
+  spatial_join->right_projection_map = join.right_projection_map;
+  spatial_join->children = std::move(join.children);
+  if (join.has_estimated_cardinality) {
+    spatial_join->SetEstimatedCardinality(join.estimated_cardinality);
+  }
+
+  op = std::move(spatial_join);
+}
+
+void S2SpatialJoinOptimize(OptimizerExtensionInput& input,
+                           unique_ptr<LogicalOperator>& plan) {
+  TryRewriteJoin(input.context, plan);
+}
+
+struct S2Knn {
+  static void Register(DatabaseInstance& instance) {
+    FunctionBuilder::RegisterScalar(instance, "s2_knn", [](ScalarFunctionBuilder& func) {
+      func.AddVariant([](ScalarFunctionVariantBuilder& variant) {
+        variant.AddParameter("geog1", Types::GEOGRAPHY());
+        variant.AddParameter("geog2", Types::GEOGRAPHY());
+        variant.AddParameter("k", LogicalType::BIGINT);
+        variant.SetReturnType(LogicalType::BOOLEAN);
+        variant.SetFunction(Execute);
+      });
+
+      func.AddVariant([](ScalarFunctionVariantBuilder& variant) {
+        variant.AddParameter("geog1", Types::GEOGRAPHY());
+        variant.AddParameter("geog2", Types::GEOGRAPHY());
+        variant.AddParameter("k", LogicalType::BIGINT);
+        variant.AddParameter("max_distance", LogicalType::DOUBLE);
+        variant.SetReturnType(LogicalType::BOOLEAN);
+        variant.SetFunction(Execute);
+      });
+
+      func.SetDescription(R"(
+Join each row to the `k` nearest rows of another table.
+
+This function can only be used as the (only) condition of an inner join, where
+it matches each row on the `geog1` side of the join to (up to) the `k` rows
+on the `geog2` side with the smallest distance to it. Optionally, rows
+further than `max_distance` meters away are never matched.
+)");
+
+      func.SetExample(R"(
+SELECT cities.name, countries.name AS country
+FROM s2_data_cities() AS cities
+INNER JOIN s2_data_countries() AS countries
+  ON s2_knn(cities.geog, countries.geog, 1)
+WHERE cities.name IN ('Toronto', 'Berlin');
+)");
+
+      func.SetTag("ext", "geography");
+      func.SetTag("category", "predicates");
+    });
+  }
+
+  static void Execute(DataChunk& args, ExpressionState& state, Vector& result) {
+    throw InvalidInputException(
+        "s2_knn() can only be used as the condition of an inner join between two "
+        "tables");
+  }
+};
+
+}  // namespace
+
+void RegisterS2SpatialJoin(DatabaseInstance& instance) {
+  S2Knn::Register(instance);
+
+  auto& config = DBConfig::GetConfig(instance);
+
+  OptimizerExtension optimizer;
+  optimizer.optimize_function = S2SpatialJoinOptimize;
+  config.optimizer_extensions.push_back(std::move(optimizer));
+}
+
+}  // namespace duckdb_s2
+}  // namespace duckdb
@@ -0,0 +1,111 @@
+import os
+import struct
+from pathlib import Path
+
+import duckdb
+import pyarrow as pa
+import pytest
+
+# Arrow extension types require a DuckDB newer than v1.1.3: build the extension
+# against the same version as the installed duckdb Python package.
+EXTENSION_PATH = os.environ.get(
+    "GEOGRAPHY_EXTENSION_PATH",
+    str(
+        Path(__file__).parents[2]
+        / "build"
+        / "release"
+        / "extension"
+        / "geography"
+        / "geography.duckdb_extension"
+    ),
+)
+
+WKB_POINT_0_1 = struct.pack("<BIdd", 1, 1, 0.0, 1.0)
+
+
+@pytest.fixture
+def con():
+    if not Path(EXTENSION_PATH).exists():
+        pytest.skip(f"extension not built at '{EXTENSION_PATH}'")
+
+    con = duckdb.connect(config={"allow_unsigned_extensions": True})
+    con.load_extension(EXTENSION_PATH)
+    return con
+
+
+def geoarrow_wkb_field(name, storage_type=pa.binary()):
+    return pa.field(
+        name,
+        storage_type,
+        metadata={
+            "ARROW:extension:name": "geoarrow.wkb",
+            "ARROW:extension:metadata": '{"edges": "spherical"}',
+        },
+    )
+
+
+def test_export_field_metadata(con):
+    table = con.sql("SELECT 'POINT (0 1)'::GEOGRAPHY AS geog").fetch_arrow_table()
+
+    field = table.schema.field("geog")
+    assert field.type == pa.binary()
+    assert field.metadata[b"ARROW:extension:name"] == b"geoarrow.wkb"
+    assert field.metadata[b"ARROW:extension:metadata"] == b'{"edges": "spherical"}'
+    assert table["geog"].to_pylist() == [WKB_POINT_0_1]
+
+
+def test_export_large_offsets(con):
+    con.sql("SET arrow_large_buffer_size = true")
+    table = con.sql("SELECT 'POINT (0 1)'::GEOGRAPHY AS geog").fetch_arrow_table()
+
+    field = table.schema.field("geog")
+    assert field.type == pa.large_binary()
+    assert field.metadata[b"ARROW:extension:name"] == b"geoarrow.wkb"
+    assert table["geog"].to_pylist() == [WKB_POINT_0_1]
+
+
+def test_export_matches_aswkb(con):
+    table = con.sql(
+        "SELECT geog, s2_aswkb(geog) AS wkb FROM s2_data_countries() ORDER BY name"
+    ).fetch_arrow_table()
+
+    assert table["geog"].to_pylist() == table["wkb"].to_pylist()
+
+
+def test_export_nulls(con):
+    table = con.sql(
+        "SELECT geog FROM (VALUES ('POINT (0 1)'::GEOGRAPHY), (NULL)) AS t(geog)"
+    ).fetch_arrow_table()
+
+    assert table["geog"].to_pylist() == [WKB_POINT_0_1, None]
+
+
+@pytest.mark.parametrize("storage_type", [pa.binary(), pa.large_binary()])
+def test_import(con, storage_type):
+    schema = pa.schema([geoarrow_wkb_field("geog", storage_type)])
+    geoarrow_table = pa.table(
+        [pa.array([WKB_POINT_0_1, None], storage_type)], schema=schema
+    )
+
+    result = con.sql(
+        "SELECT typeof(geog) AS type, s2_astext(geog) AS wkt FROM geoarrow_table"
+    ).fetchall()
+    assert result == [("GEOGRAPHY", "POINT (0 1)"), ("GEOGRAPHY", None)]
+
+
+@pytest.mark.parametrize("data", ["s2_data_cities()", "s2_data_countries()"])
+def test_roundtrip(con, data):
+    geoarrow_table = con.sql(f"SELECT name, geog FROM {data}").fetch_arrow_table()
+
+    mismatches = con.sql(
+        f"""
+        SELECT original.name
+        FROM {data} AS original
+        INNER JOIN geoarrow_table AS roundtripped ON original.name = roundtripped.name
+        WHERE s2_format(original.geog, 6) <> s2_format(roundtripped.geog, 6)
+        """
+    ).fetchall()
+    assert mismatches == []
+
+    count = con.sql("SELECT count(*) FROM geoarrow_table").fetchone()[0]
+    assert count == con.sql(f"SELECT count(*) FROM {data}").fetchone()[0]